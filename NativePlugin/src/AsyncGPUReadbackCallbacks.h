@@ -0,0 +1,41 @@
+#pragma once
+// C API for native plugins consuming readback results directly, without going through managed code.
+#include <stdbool.h>
+#include <stdint.h>
+#include "Unity/IUnityInterface.h"
+
+/**
+ * @brief What a completion callback is told about a finished request or stream frame.
+ */
+typedef struct ReadbackCompletion {
+	int handle;	//event_id of the request, or handle of the stream.
+	int state;	//State the request ended in, 3 (done) if there's data. Same values as the C# OpenGLReadbackTaskState.
+	const void* data;	//Result, only valid during the callback. Null if there's no data.
+	uint64_t length;	//Bytes of data.
+	int width;	//Size of texture region read, 0 for compute buffers.
+	int height;
+	int depth;
+	int64_t frame_number;	//Number of stream frame, counted from 0 since BeginStream. -1 for requests.
+} ReadbackCompletion;
+
+/**
+ * @brief Called once when a request or stream frame finishes, in render thread or readback thread, as soon as it's known.
+ * Should return quickly and must not call back into the plugin. Copy the data if it's needed later.
+ */
+typedef void (UNITY_INTERFACE_API *ReadbackCompletionCallback)(const ReadbackCompletion* completion, void* user_data);
+
+// The functions below are exported by the plugin library. Consumers look them up by name,
+// with GetProcAddress or dlsym, e.g. "SetCompletionCallback", and call them through these types.
+
+/**
+ * @brief Call callback when request of event_id finishes. Main thread only.
+ * If it's already finished, callback is called right away, in main thread. Null callback removes it.
+ * @return false if event_id is not a request alive.
+ */
+typedef bool (UNITY_INTERFACE_API *SetCompletionCallbackFunc)(int event_id, ReadbackCompletionCallback callback, void* user_data);
+
+/**
+ * @brief Call callback for every frame of stream that finishes from now on. Main thread only. Null callback removes it.
+ * @return false if stream_handle is not a stream alive.
+ */
+typedef bool (UNITY_INTERFACE_API *SetStreamCompletionCallbackFunc)(int stream_handle, ReadbackCompletionCallback callback, void* user_data);
@@ -1,15 +1,31 @@
 #include <cstddef>
+#include <type_traits>
 #include <vector>
-#include <map>
-#include <mutex>
 #include <memory>
 #include <cstring>
 #include "Unity/IUnityInterface.h"
 #include "Unity/IUnityGraphics.h"
 #include <iostream>
 #include "TypeHelpers.hpp"
+#include "BufferPool.hpp"
+#include "StagingRing.hpp"
+#include "TaskRegistry.hpp"
+#include "SpscQueue.hpp"
+#include "FramebufferCache.hpp"
+#include "TextureInfoCache.hpp"
+#include "CopyWorkers.hpp"
+#include "SharedContext.hpp"
+#include "AsyncGPUReadbackCallbacks.h"
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <atomic>
+#include <algorithm>
+#include <new>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 #ifdef DEBUG
 	#include <fstream>
@@ -19,15 +35,85 @@
 struct BaseTask;
 struct SsboTask;
 struct FrameTask;
+struct TextureStream;
 
 static IUnityGraphics* graphics = NULL;
 static UnityGfxRenderer renderer = kUnityGfxRendererNull;
 
-static std::map<int, std::shared_ptr<BaseTask>> tasks;
+/*
+* Command sent from main thread to render thread.
+*/
+struct RenderCommand {
+	enum Type {
+		kSubmit,	//A new task, to be started by its kickstart event.
+		kRelease,	//Main thread is done with result of task, recycle its staging memory.
+		kInvalidateTexture,	//Texture is destroyed, forget everything cached for it.
+		kBeginStream,	//Start capturing a stream every frame.
+		kEndStream,	//Stop capturing a stream, and release it once gpu is done with it.
+		kSubmitBatch,	//Tasks already submitted, to be started together by the kickstart event of the batch.
+	};
+	Type type;
+	std::shared_ptr<BaseTask> task;
+	GLuint texture = 0;
+	std::shared_ptr<TextureStream> stream;
+	int batch_id = 0;
+	std::shared_ptr<std::vector<int>> batch;
+};
+
+static TaskRegistry<BaseTask> tasks;
+//Main thread to render thread, and render thread to main thread (event_id of finished tasks).
+static SpscQueue<RenderCommand> render_commands(2 * TaskRegistry<BaseTask>::kCapacity);
+static SpscQueue<int> finished_tasks(TaskRegistry<BaseTask>::kCapacity);
+//Readback thread to main thread (event_id of tasks finished there).
+static SpscQueue<int> offthread_finished_tasks(TaskRegistry<BaseTask>::kCapacity);
+//Main thread only.
+static std::deque<RenderCommand> render_command_backlog;
 static std::vector<int> pending_release_tasks;
-static std::mutex tasks_mutex;
-int next_event_id = 1;
+static std::unordered_map<int, std::shared_ptr<TextureStream>> streams;
+//Textures in latest-frame-only mode, and how many of their results are dropped.
+static std::unordered_map<GLuint, uint64_t> mailbox_textures;
+static int next_stream_handle = 1;
+static int next_batch_handle = 1;
+//Render thread only.
+static std::unordered_map<int, std::shared_ptr<BaseTask>> submitted_tasks;
+static std::unordered_map<int, std::shared_ptr<std::vector<int>>> submitted_batches;
+//Kickstart events that ran before their submit command arrived, started once it does.
+static std::unordered_set<int> early_kickstarts;
+static std::unordered_set<int> early_batch_kickstarts;
+//Started tasks in submission order. Fences on one context signal in this order too.
+static std::deque<std::shared_ptr<BaseTask>> running_tasks;
+//Kickstarted tasks held back by the per-frame budget, still Pending, in submission order.
+static std::deque<std::shared_ptr<BaseTask>> deferred_tasks;
+static std::vector<int> finished_task_backlog;
+static std::vector<std::shared_ptr<TextureStream>> active_streams;
+//Running tasks of each texture in latest-frame-only mode, oldest first.
+static std::unordered_map<GLuint, std::deque<std::shared_ptr<BaseTask>>> running_mailbox_tasks;
+static PboPool pbo_pool;
+static StagingRing staging_ring;
+static FramebufferCache framebuffer_cache;
+static TextureInfoCache texture_info_cache;
+static CopyWorkers copy_workers;
+static std::atomic<size_t> staging_ring_size(64 * 1024 * 1024);
+//Staging memory held by running and unconsumed tasks, and the limit of it, 0 for unlimited. Written in render thread.
+static std::atomic<uint64_t> in_flight_bytes(0);
+static std::atomic<uint64_t> in_flight_byte_budget(0);
+//Transfers larger than this are split into chunks, each with its own staging memory and fence.
+static std::atomic<size_t> transfer_chunk_size(128 * 1024 * 1024);
+//Bytes the gpu is asked to copy out per frame, 0 for unlimited. Requests over it wait, larger transfers are tiled and spread across frames.
+static std::atomic<uint64_t> frame_transfer_budget(0);
+//Render thread only. Bytes issued since last UpdateRenderThread, and whether a deferrable transfer was issued meanwhile.
+static uint64_t frame_transferred_bytes = 0;
+static bool frame_chunk_issued = false;
+//Wait for fences in a thread with a shared context, instead of polling them once per frame. Set by main thread.
+static std::atomic<bool> readback_thread_wanted(false);
+//Guards completion callbacks of tasks and streams, which are set in main thread and called by whichever thread finishes them.
+static std::mutex completion_mutex;
+//Render thread only. The shared context or its thread couldn't be set up, don't try again.
+static bool readback_thread_failed = false;
+static size_t staging_ring_attempted_size = 0;
 static bool inited = false;
+// Read textures with glGetTextureSubImage instead of fbo and glReadPixels. Decided on plugin load.
+static bool use_texture_sub_image = false;
 
 extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CheckCompatible();
 static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType eventType);
@@ -36,35 +122,214 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
 template <class T> inline
 void unused(T const & result) { static_cast<void>(result); }
 
+/*
+* Memory a task reads back into. Either a range of the persistent mapped staging ring,
+* or a whole pbo borrowed from the pool.
+*/
+struct StagingBuffer {
+	GLuint buffer = 0;
+	size_t offset = 0;
+	size_t size = 0;
+	size_t pool_capacity = 0;
+	bool from_ring = false;
+};
+
+/*
+* Get staging memory for a request, prefer the staging ring if it's available. Called in render thread.
+*/
+static bool AcquireStaging(size_t size, StagingBuffer* staging) {
+	size_t wanted_ring_size = staging_ring_size;
+	if (wanted_ring_size != staging_ring_attempted_size && staging_ring.Empty()) {
+		staging_ring.Destroy();
+		staging_ring.Create(wanted_ring_size);
+		staging_ring_attempted_size = wanted_ring_size;
+	}
+
+	staging->size = size;
+	if (staging_ring.Allocate(size, &staging->offset)) {
+		staging->buffer = staging_ring.Buffer();
+		staging->from_ring = true;
+		in_flight_bytes += size;
+		return true;
+	}
+
+	//Fallback to a standalone pbo.
+	staging->offset = 0;
+	staging->from_ring = false;
+	staging->buffer = pbo_pool.Acquire(size, &staging->pool_capacity);
+	if (staging->buffer == 0) {
+		return false;
+	}
+	in_flight_bytes += size;
+	return true;
+}
+
+/*
+* Check if size more bytes of staging memory fits in budget. Called in render thread.
+* A request larger than the whole budget is still allowed when nothing else is in flight, or it would never run.
+*/
+static bool FitsInBudget(size_t size) {
+	uint64_t budget = in_flight_byte_budget;
+	uint64_t used = in_flight_bytes;
+	return budget == 0 || used == 0 || used + size <= budget;
+}
+
+/*
+* Get cpu pointer to the data. Gpu must have finished writing to it.
+* Ring memory is already mapped, pool buffers are mapped here.
+*/
+static char* MapStaging(const StagingBuffer& staging) {
+	if (staging.from_ring) {
+		return staging_ring.Data() + staging.offset;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, staging.buffer);
+	void* ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, staging.size, GL_MAP_READ_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return static_cast<char*>(ptr);
+}
+
+static void UnmapStaging(const StagingBuffer& staging) {
+	if (staging.from_ring || staging.buffer == 0) {
+		return;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, staging.buffer);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/*
+* Give back staging memory. It's only recycled if recycle is true, which means fence is retired.
+*/
+static void ReleaseStaging(StagingBuffer* staging, bool recycle) {
+	if (staging->buffer == 0) {
+		return;
+	}
+	in_flight_bytes -= staging->size;
+	if (staging->from_ring) {
+		// The range can't be discarded alone, it's released anyway.
+		staging_ring.Release(staging->offset);
+	}
+	else if (recycle) {
+		pbo_pool.Release(staging->buffer, staging->pool_capacity);
+	}
+	else {
+		pbo_pool.Discard(staging->buffer, staging->pool_capacity);
+	}
+	staging->buffer = 0;
+}
+
+/*
+* Size of chunks a transfer is split into, no larger than the per-frame budget. Called in render thread.
+*/
+static size_t ChunkSize() {
+	size_t size = transfer_chunk_size;
+	uint64_t budget = frame_transfer_budget;
+	if (budget != 0 && budget < size) {
+		size = (size_t)budget;
+	}
+	return size;
+}
+
+/*
+* Count a transfer against the per-frame budget. Called in render thread.
+* @param deferrable Whether the transfer could wait for next frame, a chunk or a kickstarted request.
+* At least one of these goes every frame, so they always progress.
+* @return false if it should wait.
+*/
+static bool TakeFrameTransfer(size_t size, bool deferrable) {
+	uint64_t budget = frame_transfer_budget;
+	if (deferrable && budget != 0 && frame_chunk_issued && frame_transferred_bytes + size > budget) {
+		return false;
+	}
+	frame_transferred_bytes += size;
+	frame_chunk_issued = frame_chunk_issued || deferrable;
+	return true;
+}
+
+/*
+* A fence shared by the tasks of a batch. Deleted once the last of them lets it go, in render thread or readback thread.
+*/
+struct SharedFence {
+	GLsync sync;
+
+	explicit SharedFence(GLsync _sync) : sync(_sync) {}
+
+	~SharedFence() {
+		if (sync != 0) {
+			glDeleteSync(sync);
+		}
+	}
+};
+
 struct BaseTask {
 	//These vars might be accessed from both render thread and main thread. guard them.
-	std::atomic<bool> initialized;
 	std::atomic<bool> error;
 	std::atomic<bool> done;
+	//Handle in task registry, set once when inserted.
+	int event_id = 0;
+	//Set when data is handed out to main thread. The result is kept alive until ReleaseData. Only accessed in main thread.
+	bool leased = false;
+	//Set once data is handed out to main thread by GetData or GetAvailableData. Only accessed in main thread.
+	bool read = false;
+	//Caller-provided memory to write result into. If null, result is leased from staging memory instead.
+	char* destination = nullptr;
+	size_t destination_capacity = 0;
+	//Texture whose latest result only is wanted, 0 if not in latest-frame-only mode. Set once when created.
+	GLuint mailbox_texture = 0;
+	//Render thread only. A newer task of the same mailbox texture is done first, so result of this one is dropped once the copies it started land.
+	bool superseded = false;
+	bool dropped = false;
+	//Render thread only. Staging memory isn't acquired as budget is used up.
+	bool over_budget = false;
+	//Render thread only. Started as part of a batch, whose tasks share one fence made once all of them are started.
+	bool in_batch = false;
+	//Render thread only. StartRequest may hold the task back when the per-frame budget is used up, which sets deferred.
+	//Only set for requests started by their kickstart event, others must be issued where they're started.
+	bool may_defer = false;
+	bool deferred = false;
+	//Native consumer to call once finished. Guarded by completion_mutex, reported is set once it's called or would have been.
+	ReadbackCompletionCallback completion_callback = nullptr;
+	void* completion_user_data = nullptr;
+	bool completion_reported = false;
+	//Result memory, and how many bytes from its beginning are already written. Grows chunk by chunk for chunked transfers.
+	//Written by render thread, could be read by main thread while running.
+	std::atomic<char*> available_data;
+	std::atomic<uint64_t> available_bytes;
 	/*Called in render thread*/
 	virtual void StartRequest() = 0;
 	virtual void Update() = 0;
 
 	BaseTask() :
-		initialized(false),
 		error(false),
-		done(false)
+		done(false),
+		available_data(nullptr),
+		available_bytes(0)
 	{
 
 	}
 
 	virtual ~BaseTask()
 	{
-		if (result_data != nullptr) {
-			delete[] result_data;
-		}
+		//Staging memory is given back by ReleaseResult in render thread, nothing to do here.
 	}
 	
+	/*
+	* Called in main thread. The staged result is only copied to caller-provided destination on first call,
+	* so results nobody reads are never touched by cpu.
+	*/
 	char* GetData(size_t* length) {
 		if (!done || error) {
 			return nullptr;
 		}
-		std::lock_guard<std::mutex> guard(mainthread_data_mutex);
+		if (this->result_data == nullptr && this->staged_data != nullptr) {
+			if (destination != nullptr) {
+				copy_workers.CopyAndWait(destination, staged_data, result_data_length);
+				this->result_data = destination;
+			}
+			else {
+				this->result_data = staged_data;
+			}
+		}
 		if (this->result_data == nullptr) {
 			return nullptr;
 		}
@@ -72,18 +337,365 @@ struct BaseTask {
 		return result_data;
 	}
 
+	/*
+	* Result of a task just finished, before main thread resolves it. Called by the thread finishing the task.
+	* A caller-provided destination isn't written yet, the staged data is returned then.
+	*/
+	const char* FinishedData(size_t* length) const {
+		const char* data = result_data != nullptr ? result_data : staged_data;
+		*length = data != nullptr ? result_data_length : 0;
+		return data;
+	}
+
+	/*
+	* Size of the region read, 0 if it's not a texture.
+	*/
+	virtual void GetExtent(int* width, int* height, int* depth) const {
+		*width = 0;
+		*height = 0;
+		*depth = 0;
+	}
+
+	/*
+	* Called in render thread once main thread doesn't need the result anymore.
+	* Unmap the staging memory and give it back.
+	*/
+	void ReleaseResult() {
+		if (staged_data != nullptr) {
+			UnmapStaging(staging);
+			staged_data = nullptr;
+		}
+		result_data = nullptr;
+		ReleaseStaging(&staging, true);
+		if (chunked_result != nullptr) {
+			in_flight_bytes -= chunked_length;
+			chunked_result.reset();
+		}
+		available_data = nullptr;
+		available_bytes = 0;
+	}
+
+	/*
+	* Called in render thread, to start the task again after it's finished. The previous result is released.
+	*/
+	virtual void Reset() {
+		ReleaseResult();
+		error = false;
+		done = false;
+		completion_reported = false;
+		superseded = false;
+		dropped = false;
+		over_budget = false;
+		chunks.clear();
+		issued_chunks = 0;
+		copying_chunks = 0;
+		landed_chunks = 0;
+	}
+
+	/*
+	* Called in render thread. Some chunks are held back by the per-frame budget, so fences of later tasks could signal first.
+	*/
+	bool Throttled() const {
+		return issued_chunks < chunks.size();
+	}
+
+	/*
+	* Called in render thread after StartRequest. The only fence to wait for, if finishing the task then needs
+	* nothing owned by render thread: result is staged in ring, which is already mapped, and it's not in a mailbox.
+	* Such task could be finished in readback thread. 0 otherwise.
+	*/
+	GLsync OffThreadFence() const {
+		if (mailbox_texture != 0 || !chunks.empty() || !staging.from_ring) {
+			return 0;
+		}
+		return fence;
+	}
+
+	/*
+	* Called in render thread once every task of its batch is started. Take the batch fence, if there's a copy to wait for.
+	* @return false if it's not needed.
+	*/
+	bool AdoptFence(const std::shared_ptr<SharedFence>& batch_fence) {
+		if (done || !chunks.empty() || fence != 0) {
+			return false;
+		}
+		if (batch_fence != nullptr) {
+			shared_fence = batch_fence;
+			fence = batch_fence->sync;
+		}
+		return true;
+	}
+
 protected:
+	//Fence of the copy into staging memory, for tasks not transferred in chunks.
+	GLsync fence = 0;
+	//Set if fence belongs to a batch, it's deleted with the last task letting it go.
+	std::shared_ptr<SharedFence> shared_fence;
+
+	/*
+	* Called by subclass once the copy into staging memory is issued. Tasks of a batch take the batch fence later instead.
+	*/
+	void CreateFence() {
+		if (!in_batch) {
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+	}
+
+	void DeleteFence() {
+		if (fence != 0 && shared_fence == nullptr) {
+			glDeleteSync(fence);
+		}
+		fence = 0;
+		shared_fence.reset();
+	}
+
+	StagingBuffer staging;
+
+	/*
+	* A piece of a large transfer, with its own staging memory and fence.
+	*/
+	struct Chunk {
+		StagingBuffer staging;
+		GLsync fence = 0;
+		size_t offset = 0;	//Offset in result.
+		size_t size = 0;
+		//Mapped staging memory being copied out by copy workers.
+		char* mapped = nullptr;
+		std::shared_ptr<CopyBatch> copy;
+	};
+	//Chunks are issued, then copied out once fence signals, then landed once copy is done. In this order.
+	std::vector<Chunk> chunks;
+	size_t issued_chunks = 0;
+	size_t copying_chunks = 0;
+	size_t landed_chunks = 0;
+	//Result of a chunked transfer without caller-provided destination.
+	std::unique_ptr<char[]> chunked_result;
+	size_t chunked_length = 0;
+
+	/*
+	* Called by subclass for each chunk of a chunked transfer, with staging memory of chunk bound to GL_PIXEL_PACK_BUFFER.
+	*/
+	virtual void CopyChunk(const Chunk& chunk) = 0;
+
+	static bool NeedsChunks(size_t length) {
+		return length > ChunkSize();
+	}
+
+	/*
+	* Called by subclass in StartRequest instead of PrepareStaging, if NeedsChunks(length).
+	* Splits the transfer into chunks of whole units, and starts as many as the per-frame budget allows.
+	* They land in caller-provided destination, or in a heap buffer allocated here, so no huge pbo is needed.
+	*/
+	bool StartChunks(size_t length, size_t unit) {
+		if (destination != nullptr && length > destination_capacity) {
+			return false;
+		}
+		if (!FitsInBudget(length)) {
+			over_budget = true;
+			return false;
+		}
+		char* result = destination;
+		if (result == nullptr) {
+			chunked_result.reset(new (std::nothrow) char[length]);
+			if (chunked_result == nullptr) {
+				return false;
+			}
+			result = chunked_result.get();
+			in_flight_bytes += length;
+		}
+		chunked_length = length;
+
+		size_t chunk_size = std::max(unit, ChunkSize() / unit * unit);
+		for (size_t offset = 0; offset < length; offset += chunk_size) {
+			Chunk chunk;
+			chunk.offset = offset;
+			chunk.size = std::min(chunk_size, length - offset);
+			chunks.push_back(chunk);
+		}
+		available_data = result;
+		return IssueChunks();
+	}
+
+	/*
+	* Start the chunks not started yet, as long as the per-frame budget allows.
+	* Chunks of a superseded task aren't started anymore, the task ends once the started ones land.
+	*/
+	bool IssueChunks() {
+		if (superseded) {
+			chunks.resize(issued_chunks);
+			return true;
+		}
+		while (issued_chunks < chunks.size()) {
+			Chunk& chunk = chunks[issued_chunks];
+			if (!TakeFrameTransfer(chunk.size, true)) {
+				break;
+			}
+			if (!AcquireStaging(chunk.size, &chunk.staging)) {
+				AbortChunks();
+				return false;
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, chunk.staging.buffer);
+			CopyChunk(chunk);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			chunk.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			issued_chunks++;
+		}
+		return true;
+	}
+
+	/*
+	* Called by subclass in Update of a chunked transfer. Chunks whose fence is signaled are handed to copy workers,
+	* and land in order once copied, so completed part of the result is available before the whole transfer is done.
+	* Their staging memory is unmapped and recycled on a later update, render thread never waits for a copy.
+	*/
+	void UpdateChunks() {
+		if (!IssueChunks()) {
+			ErrorOut();
+			return;
+		}
+		char* result = available_data;
+		while (copying_chunks < issued_chunks) {
+			Chunk& chunk = chunks[copying_chunks];
+			GLint status = 0;
+			GLsizei length = 0;
+			glGetSynciv(chunk.fence, GL_SYNC_STATUS, sizeof(GLint), &length, &status);
+			if (length <= 0) {
+				AbortChunks();
+				ErrorOut();
+				return;
+			}
+			if (status != GL_SIGNALED) {
+				break;
+			}
+			glDeleteSync(chunk.fence);
+			chunk.fence = 0;
+
+			// Nobody wants a superseded result, only recycle its staging memory.
+			if (!superseded) {
+				chunk.mapped = MapStaging(chunk.staging);
+				if (chunk.mapped == nullptr) {
+					AbortChunks();
+					ErrorOut();
+					return;
+				}
+				chunk.copy = copy_workers.Copy(result + chunk.offset, chunk.mapped, chunk.size);
+			}
+			copying_chunks++;
+		}
+
+		while (landed_chunks < copying_chunks) {
+			Chunk& chunk = chunks[landed_chunks];
+			if (chunk.copy != nullptr && !chunk.copy->Done()) {
+				return;
+			}
+			LandChunk(&chunk);
+			landed_chunks++;
+			available_bytes.store(chunk.offset + chunk.size, std::memory_order_release);
+		}
+		if (landed_chunks < chunks.size()) {
+			return;
+		}
+
+		if (superseded) {
+			dropped = true;
+			done = true;
+			return;
+		}
+		FinishAndCommitData(result, chunked_length);
+	}
+
+	/*
+	* Give back staging memory of a chunk that is copied out.
+	*/
+	static void LandChunk(Chunk* chunk) {
+		chunk->copy.reset();
+		if (chunk->mapped != nullptr) {
+			UnmapStaging(chunk->staging);
+			chunk->mapped = nullptr;
+		}
+		ReleaseStaging(&chunk->staging, true);
+	}
+
+	/*
+	* Give up chunks not landed yet, their staging memory might still be written by gpu.
+	*/
+	void AbortChunks() {
+		for (size_t i = landed_chunks; i < copying_chunks; i++) {
+			copy_workers.Wait(chunks[i].copy);
+			LandChunk(&chunks[i]);
+		}
+		for (size_t i = copying_chunks; i < issued_chunks; i++) {
+			ReleaseStaging(&chunks[i].staging, false);
+			if (chunks[i].fence != 0) {
+				glDeleteSync(chunks[i].fence);
+			}
+		}
+		chunks.clear();
+		issued_chunks = 0;
+		copying_chunks = 0;
+		landed_chunks = 0;
+	}
+
+	/*
+	* Called by subclass in StartRequest, to get staging memory for length bytes.
+	* Fails if the result won't fit in caller-provided destination, or in the in-flight budget.
+	* Also fails with deferred set if it should wait for next frame, StartRequest is then called again.
+	*/
+	bool PrepareStaging(size_t length) {
+		if (destination != nullptr && length > destination_capacity) {
+			return false;
+		}
+		//Fits in one chunk, so it's held back as a whole, or issued even over the per-frame budget if it can't wait.
+		if (!TakeFrameTransfer(length, may_defer)) {
+			deferred = true;
+			return false;
+		}
+		if (!FitsInBudget(length)) {
+			over_budget = true;
+			return false;
+		}
+		if (!AcquireStaging(length, &staging)) {
+			return false;
+		}
+		return true;
+	}
+
+	/*
+	* Called by subclass in Update once the fence is signaled. Only records where the result is, nothing is copied here.
+	* The staged memory becomes the result directly, or is copied to caller-provided destination on first GetData.
+	* Ring memory is persistently mapped, so it costs nothing until read. A pool buffer has to be mapped here, in render thread.
+	*/
+	void FinishAndCommitStaging(size_t length) {
+		if (superseded) {
+			// Nobody wants it, recycle staging memory without even mapping it.
+			ReleaseStaging(&staging, true);
+			dropped = true;
+			done = true;
+			return;
+		}
+		char* ptr = MapStaging(staging);
+		if (ptr == nullptr) {
+			ErrorOut();
+			ReleaseStaging(&staging, true);
+			return;
+		}
+		this->staged_data = ptr;
+		this->result_data_length = length;
+		done = true;
+	}
+
 	/*
-	* Called by subclass in Update, to commit data and mark as done.
+	* Commit data and mark as done. The memory is not owned by task.
 	*/
 	void FinishAndCommitData(char* dataPtr, size_t length) {
-		std::lock_guard<std::mutex> guard(mainthread_data_mutex);
 		if (this->result_data != nullptr) {
 			//WTF
 			return;
 		}
 		this->result_data = dataPtr;
 		this->result_data_length = length;
+		available_data = dataPtr;
+		available_bytes.store(length, std::memory_order_release);
 		done = true;
 	}
 
@@ -95,186 +707,789 @@ protected:
 		done = true;
 	}
 private:
-	std::mutex mainthread_data_mutex;
-	char* result_data = nullptr;
+	//Written by render thread before the task is published as done, read by main thread after that. No lock needed.
+	//The mapped staging memory of the result, if it's not copied out yet.
+	char* staged_data = nullptr;
 	size_t result_data_length = 0;
+	//Set by render thread for chunked results, or by main thread on first GetData otherwise.
+	char* result_data = nullptr;
 };
 
 /*Task for readback from ssbo. Which is compute buffer in Unity
 */
 struct SsboTask : public BaseTask {
-	GLuint ssbo;
-	GLuint pbo;
-	GLsync fence;
-	GLint bufferSize;
-	void Init(GLuint _ssbo, GLint _bufferSize) {
+	GLuint ssbo = 0;
+	GLintptr offset = 0;
+	GLsizeiptr bufferSize = 0;
+	void Init(GLuint _ssbo, GLsizeiptr _bufferSize, GLintptr _offset = 0) {
 		this->ssbo = _ssbo;
 		this->bufferSize = _bufferSize;
+		this->offset = _offset;
 	}
 
 	virtual void StartRequest() override {
 		//bind it to GL_COPY_WRITE_BUFFER to wait for use
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ssbo);
 
+		//The range must be inside the buffer, otherwise the copy fails silently.
+		GLint64 ssboSize = 0;
+		glGetBufferParameteri64v(GL_SHADER_STORAGE_BUFFER, GL_BUFFER_SIZE, &ssboSize);
+		if (bufferSize <= 0 || offset < 0 || (GLint64)offset + bufferSize > ssboSize) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			ErrorOut();
+			return;
+		}
+
+		//Large buffer is copied in chunks.
+		if (NeedsChunks(bufferSize)) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			if (!StartChunks(bufferSize, 1)) {
+				ErrorOut();
+			}
+			return;
+		}
+
 		//Get our pbo ready.
-		glGenBuffers(1, &pbo);
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, this->pbo);
-		//Initialize pbo buffer storage.
-		glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, 0, GL_STREAM_READ);
+		if (!PrepareStaging(bufferSize)) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			if (!deferred)
+				ErrorOut();
+			return;
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, staging.buffer);
 
 		//Copy data to pbo.
-		glCopyBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_PIXEL_PACK_BUFFER, 0, 0, bufferSize);
+		glCopyBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_PIXEL_PACK_BUFFER, offset, staging.offset, bufferSize);
 
 		//Unbind buffers.
 		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
 		//Create a fence.
-		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		CreateFence();
+	}
+
+	virtual void CopyChunk(const Chunk& chunk) override {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ssbo);
+		glCopyBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_PIXEL_PACK_BUFFER, offset + chunk.offset, chunk.staging.offset, chunk.size);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 	}
 
 	virtual void Update() override {
+		if (!chunks.empty()) {
+			UpdateChunks();
+			return;
+		}
+
 		// Check fence state
 		GLint status = 0;
 		GLsizei length = 0;
 		glGetSynciv(fence, GL_SYNC_STATUS, sizeof(GLint), &length, &status);
 		if (length <= 0) {
 			ErrorOut();
+			ReleaseStaging(&staging, false);
 			Cleanup();
 			return;
 		}
 
 		// When it's done
 		if (status == GL_SIGNALED) {
-
-			// Bind back the pbo
-			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-
-			// Map the buffer and copy it to data
-			void* ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bufferSize, GL_MAP_READ_BIT);
-
-			// Allocate the final data buffer !!! WARNING: free, will have to be done on script side !!!!
-			char* data = new char[bufferSize];
-			std::memcpy(data, ptr, bufferSize);
-			FinishAndCommitData(data, bufferSize);
-
-			// Unmap and unbind
-			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			// Map the buffer, it stays mapped until the result is released.
+			FinishAndCommitStaging(bufferSize);
 			Cleanup();
 		}
 	}
 
 	void Cleanup()
 	{
-		if (pbo != 0) {
-			// Clear buffers
-			glDeleteBuffers(1, &(pbo));
-		}
-		if (fence != 0) {
-			glDeleteSync(fence);
-		}
+		DeleteFence();
 	}
 };
 
+/*
+* Find out the target a texture was created with. Called in render thread.
+* Uses GL_TEXTURE_TARGET query if DSA is available, otherwise tries to bind it to each target Unity might use.
+* @return 0 if not found.
+*/
+static GLenum GetTextureTarget(GLuint texture) {
+	if ((GLEW_ARB_direct_state_access || GLEW_VERSION_4_5) && glGetTextureParameteriv != nullptr) {
+		GLint target = 0;
+		glGetTextureParameteriv(texture, GL_TEXTURE_TARGET, &target);
+		return (GLenum)target;
+	}
+
+	static const GLenum candidates[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_ARRAY };
+	//Clear errors left by others, so they're not mistaken as ours.
+	for (int i = 0; i < 16 && glGetError() != GL_NO_ERROR; i++) {}
+	for (GLenum target : candidates) {
+		glBindTexture(target, texture);
+		bool bound = glGetError() == GL_NO_ERROR;
+		glBindTexture(target, 0);
+		if (bound) {
+			return target;
+		}
+	}
+	return 0;
+}
+
 /*Task for readback texture.
+* Reads the region starting at (x, y, z) of size (width, height, depth) from level miplevel.
+* z and depth are slices of 3D texture, layers of texture array, or faces of cubemap (array).
+* A size of 0 means up to the end of the level.
 */
 struct FrameTask : public BaseTask {
-	int size;
-	GLsync fence;
-	GLuint texture;
-	GLuint fbo;
-	GLuint pbo;
-	int miplevel;
-	int height;
-	int width;
-	int depth;
-	GLint internal_format;
+	size_t size = 0;
+	GLuint texture = 0;
+	GLenum target = 0;
+	int miplevel = 0;
+	int x = 0;
+	int y = 0;
+	int z = 0;
+	int height = 0;
+	int width = 0;
+	int depth = 0;
+	GLint internal_format = 0;
+	//Level info given by the requester, no need to ask driver.
+	bool has_level_info = false;
+	TextureLevelInfo level_info;
+	//Region as requested, before a size of 0 is resolved to the rest of level.
+	int requested_width = 0;
+	int requested_height = 0;
+	int requested_depth = 0;
 	virtual void StartRequest() override {
-		// Get texture informations
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glGetTexLevelParameteriv(GL_TEXTURE_2D, miplevel, GL_TEXTURE_WIDTH, &(width));
-		glGetTexLevelParameteriv(GL_TEXTURE_2D, miplevel, GL_TEXTURE_HEIGHT, &(height));
-		glGetTexLevelParameteriv(GL_TEXTURE_2D, miplevel, GL_TEXTURE_DEPTH, &(depth));
-		glGetTexLevelParameteriv(GL_TEXTURE_2D, miplevel, GL_TEXTURE_INTERNAL_FORMAT, &(internal_format));
+		requested_width = width;
+		requested_height = height;
+		requested_depth = depth;
+
+		// Get texture informations. The name of a cached texture might be reused by a new one, so it's checked first.
+		if (!has_level_info && !(texture_info_cache.Find(texture, miplevel, &level_info) && CachedLevelInfoMatches(level_info))) {
+			if (!QueryLevelInfo(&level_info)) {
+				ErrorOut();
+				return;
+			}
+			texture_info_cache.Add(texture, miplevel, level_info);
+		}
+		target = level_info.target;
+		internal_format = level_info.internal_format;
+		GLint level_width = level_info.width;
+		GLint level_height = level_info.height;
+		GLint level_depth = level_info.depth;
+
+		// Region defaults to the rest of the level
+		if (width <= 0)
+			width = level_width - x;
+		if (height <= 0)
+			height = level_height - y;
+		if (depth <= 0)
+			depth = level_depth - z;
+
 		int pixelBits = getPixelSizeFromInternalFormat(internal_format);
-		size = depth * width * height * pixelBits / 8;
+		size = (size_t)depth * width * height * pixelBits / 8;
+		GLenum format = getFormatFromInternalFormat(internal_format);
 		// Check for errors
-		if (size == 0
+		if (width <= 0 || height <= 0 || depth <= 0 || size == 0
+			|| x < 0 || y < 0 || z < 0
+			|| x + width > level_width || y + height > level_height || z + depth > level_depth
 			|| pixelBits % 8 != 0	//Only support textures aligned to one byte.
-			|| getFormatFromInternalFormat(internal_format) == 0
-			|| getTypeFromInternalFormat(internal_format) == 0) {
+			|| format == 0
+			|| getTypeFromInternalFormat(internal_format) == 0
+			|| (!use_texture_sub_image && (format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL))) {	//Can't be read from color attachment.
 			ErrorOut();
 			return;
 		}
 
-		// Create the fbo (frame buffer object) from the given texture
-		glGenFramebuffers(1, &(fbo));
+		// Large texture is read in chunks of rows
+		if (NeedsChunks(size)) {
+			if (!StartChunks(size, size / ((size_t)depth * height))) {
+				ErrorOut();
+			}
+			return;
+		}
+
+		// Borrow staging memory for the pixels
+		if (!PrepareStaging(size)) {
+			if (!deferred)
+				ErrorOut();
+			return;
+		}
 
-		// Bind the texture to the fbo
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0);
+		// Bind pbo (pixel buffer object) as destination of reads
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, staging.buffer);
 
-		// Create and bind pbo (pixel buffer object) to fbo
-		glGenBuffers(1, &(pbo));
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-		glBufferData(GL_PIXEL_PACK_BUFFER, size, 0, GL_DYNAMIC_READ);
+		// Rows are tightly packed in the result, whatever the width is
+		GLint pack_alignment = 4;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
 
 		// Start the read request
-		glReadBuffer(GL_COLOR_ATTACHMENT0);
-		glReadPixels(0, 0, width, height, getFormatFromInternalFormat(internal_format), getTypeFromInternalFormat(internal_format), 0);
+		if (use_texture_sub_image)
+			ReadWithGetTextureSubImage();
+		else
+			ReadWithFramebuffer();
 
 		// Unbind buffers
+		glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
 		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 		// Fence to know when it's ready
-		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		CreateFence();
+	}
+
+	/*
+	* Check cached info still describes the level, with the few queries finding a texture recreated under the same name.
+	* Target is trusted, finding it is what costs most.
+	*/
+	bool CachedLevelInfoMatches(const TextureLevelInfo& info) {
+		GLenum level_target = info.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : info.target;
+		GLint level_width = 0;
+		GLint level_height = 0;
+		GLint level_format = 0;
+		glBindTexture(info.target, texture);
+		glGetTexLevelParameteriv(level_target, miplevel, GL_TEXTURE_WIDTH, &level_width);
+		glGetTexLevelParameteriv(level_target, miplevel, GL_TEXTURE_HEIGHT, &level_height);
+		glGetTexLevelParameteriv(level_target, miplevel, GL_TEXTURE_INTERNAL_FORMAT, &level_format);
+		return level_width == info.width && level_height == info.height && level_format == info.internal_format;
+	}
+
+	/*
+	* Ask driver about the level, each query might stall on the driver thread.
+	* @return false if texture target is not supported.
+	*/
+	bool QueryLevelInfo(TextureLevelInfo* info) {
+		info->target = GetTextureTarget(texture);
+		if (info->target != GL_TEXTURE_2D && info->target != GL_TEXTURE_3D && info->target != GL_TEXTURE_2D_ARRAY
+			&& info->target != GL_TEXTURE_CUBE_MAP && info->target != GL_TEXTURE_CUBE_MAP_ARRAY) {
+			return false;
+		}
+
+		// Level of cubemap is queried on one of its faces
+		GLenum level_target = info->target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : info->target;
+		glBindTexture(info->target, texture);
+		glGetTexLevelParameteriv(level_target, miplevel, GL_TEXTURE_WIDTH, &(info->width));
+		glGetTexLevelParameteriv(level_target, miplevel, GL_TEXTURE_HEIGHT, &(info->height));
+		glGetTexLevelParameteriv(level_target, miplevel, GL_TEXTURE_DEPTH, &(info->depth));
+		glGetTexLevelParameteriv(level_target, miplevel, GL_TEXTURE_INTERNAL_FORMAT, &(info->internal_format));
+		if (info->target == GL_TEXTURE_CUBE_MAP)
+			info->depth = 6;
+		return true;
+	}
+
+	/*
+	* Copy the whole region into the bound pbo with one call, no fbo needed.
+	* Layers and cubemap faces are addressed by z directly.
+	*/
+	void ReadWithGetTextureSubImage() {
+		glGetTextureSubImage(texture, miplevel, x, y, z, width, height, depth,
+			getFormatFromInternalFormat(internal_format), getTypeFromInternalFormat(internal_format),
+			(GLsizei)size, reinterpret_cast<void*>(staging.offset));
+	}
+
+	/*
+	* Attach the texture to an fbo (frame buffer object), and read it into the bound pbo one layer after another.
+	*/
+	void ReadWithFramebuffer() {
+		size_t layer_size = size / depth;
+		for (int layer = 0; layer < depth; layer++) {
+			ReadRows(layer, 0, height, staging.offset + layer * layer_size);
+		}
+	}
+
+	/*
+	* Read rows [row, row + rows) of the region in its layer-th layer into the bound pbo at pack_offset.
+	* Fbos are cached per layer, so reading the same textures every frame doesn't create any.
+	*/
+	void ReadRows(int layer, int row, int rows, size_t pack_offset) {
+		GLenum format = getFormatFromInternalFormat(internal_format);
+		GLenum type = getTypeFromInternalFormat(internal_format);
+		if (use_texture_sub_image) {
+			GLsizei length = (GLsizei)(size / ((size_t)depth * height) * rows);
+			glGetTextureSubImage(texture, miplevel, x, y + row, z + layer, width, rows, 1, format, type, length, reinterpret_cast<void*>(pack_offset));
+			return;
+		}
+
+		// Bind the texture layer to the fbo
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_cache.Get(texture, miplevel, z + layer));
+		AttachLayer(z + layer);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glReadPixels(x, y + row, width, rows, format, type, reinterpret_cast<void*>(pack_offset));
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	/*
+	* Attach one layer of the level to color attachment of currently bound fbo.
+	*/
+	void AttachLayer(int layer) {
+		if (target == GL_TEXTURE_2D)
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, miplevel);
+		else if (target == GL_TEXTURE_CUBE_MAP)
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, texture, miplevel);
+		else
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, miplevel, layer);
+	}
+
+	/*
+	* A chunk is a range of whole rows, counted through layers one after another.
+	*/
+	virtual void CopyChunk(const Chunk& chunk) override {
+		GLint pack_alignment = 4;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+		size_t row_size = size / ((size_t)depth * height);
+		size_t row = chunk.offset / row_size;
+		size_t row_count = chunk.size / row_size;
+		size_t pack_offset = chunk.staging.offset;
+		while (row_count > 0) {
+			int layer = (int)(row / height);
+			int layer_row = (int)(row % height);
+			int rows = (int)std::min(row_count, (size_t)(height - layer_row));
+			ReadRows(layer, layer_row, rows, pack_offset);
+			pack_offset += rows * row_size;
+			row += rows;
+			row_count -= rows;
+		}
+
+		glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
 	}
 
 	virtual void Update() override {
+		if (!chunks.empty()) {
+			UpdateChunks();
+			return;
+		}
+
 		// Check fence state
 		GLint status = 0;
 		GLsizei length = 0;
 		glGetSynciv(fence, GL_SYNC_STATUS, sizeof(GLint), &length, &status);
 		if (length <= 0) {
 			ErrorOut();
+			ReleaseStaging(&staging, false);
 			Cleanup();
 			return;
 		}
 
 		// When it's done
 		if (status == GL_SIGNALED) {
-
-			// Bind back the pbo
-			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-
-			// Map the buffer and copy it to data
-
-			char* data = new char[size];
-			void* ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
-			std::memcpy(data, ptr, size);
-			FinishAndCommitData(data, size);
-
-			// Unmap and unbind
-			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			// Map the buffer, it stays mapped until the result is released.
+			FinishAndCommitStaging(size);
 			Cleanup();
 		}
 	}
 
-	void Cleanup()
-	{
+	virtual void GetExtent(int* width, int* height, int* depth) const override {
+		*width = this->width;
+		*height = this->height;
+		*depth = this->depth;
+	}
+
+	/*
+	* The region is resolved again on next start, so a resized texture is followed.
+	*/
+	virtual void Reset() override {
+		BaseTask::Reset();
+		width = requested_width;
+		height = requested_height;
+		depth = requested_depth;
+	}
+
+	void Cleanup()
+	{
 		// Clear buffers
-		if (fbo != 0)
-			glDeleteFramebuffers(1, &(fbo));
-		if (pbo != 0)
-			glDeleteBuffers(1, &(pbo));
-		if (fence != 0)
-			glDeleteSync(fence);
+		DeleteFence();
 	}
 };
 
+/*
+* Call a completion callback with what's known about a finished task.
+*/
+static void CallCompletion(ReadbackCompletionCallback callback, void* user_data, const BaseTask& task, int handle, TaskState state, int64_t frame_number) {
+	ReadbackCompletion completion;
+	completion.handle = handle;
+	completion.state = state;
+	size_t length = 0;
+	completion.data = state == kTaskStateDone ? task.FinishedData(&length) : nullptr;
+	completion.length = completion.data != nullptr ? length : 0;
+	task.GetExtent(&completion.width, &completion.height, &completion.depth);
+	completion.frame_number = frame_number;
+	callback(&completion, user_data);
+}
+
+/*
+* Called by the thread finishing task, before it's handed to main thread. Calls its callback if there's one,
+* after this main thread calls a callback set later itself.
+*/
+static void ReportCompletion(BaseTask* task, TaskState state) {
+	ReadbackCompletionCallback callback = nullptr;
+	void* user_data = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(completion_mutex);
+		task->completion_reported = true;
+		callback = task->completion_callback;
+		user_data = task->completion_user_data;
+	}
+	if (callback != nullptr) {
+		CallCompletion(callback, user_data, *task, task->event_id, state, -1);
+	}
+}
+
+/*
+* State a finished task is published as.
+*/
+static TaskState FinishedStateOf(const BaseTask* task) {
+	if (task->dropped)
+		return kTaskStateDropped;
+	else if (task->over_budget)
+		return kTaskStateOverBudget;
+	else if (task->error)
+		return kTaskStateError;
+	return kTaskStateDone;
+}
+
+/*
+* A texture level captured every frame into a ring of tasks, which are reused forever,
+* so steady state capture doesn't allocate anything.
+*
+* Slot states are shared between threads. Render thread moves Free and Ready slots to Writing,
+* and Writing slots to Ready or Free. Main thread moves Ready slots to Acquired and back.
+*/
+struct TextureStream {
+	enum SlotState {
+		kSlotFree,
+		kSlotWriting,	//Gpu is writing to it.
+		kSlotReady,	//Holds a finished frame.
+		kSlotAcquired,	//Main thread is reading it.
+	};
+
+	struct Slot {
+		std::shared_ptr<FrameTask> task;
+		std::atomic<int> state;
+		std::atomic<int64_t> frame_number;
+
+		Slot() :
+			state(kSlotFree),
+			frame_number(-1)
+		{
+
+		}
+	};
+
+	std::vector<Slot> slots;
+	//Set once when created.
+	int handle = 0;
+	//Guarded by completion_mutex.
+	ReadbackCompletionCallback completion_callback = nullptr;
+	void* completion_user_data = nullptr;
+	//Render thread only.
+	int64_t next_frame_number = 0;
+	bool ended = false;
+	//Main thread only.
+	int acquired_slot = -1;
+
+	TextureStream(GLuint texture, int miplevel, int ring_depth) :
+		slots(ring_depth)
+	{
+		for (auto& slot : slots) {
+			slot.task = std::make_shared<FrameTask>();
+			slot.task->texture = texture;
+			slot.task->miplevel = miplevel;
+		}
+	}
+
+	/*
+	* Called in render thread every frame. Start next frame in a free slot or the oldest ready one,
+	* then check slots gpu is writing to. A frame finished now stays ready at least until next update.
+	* @return false once the stream is ended and gpu doesn't use it anymore.
+	*/
+	bool Update() {
+		if (!ended) {
+			Capture();
+		}
+
+		bool writing = false;
+		for (auto& slot : slots) {
+			if (slot.state.load(std::memory_order_acquire) != kSlotWriting) {
+				continue;
+			}
+			slot.task->Update();
+			if (!slot.task->done) {
+				writing = true;
+			}
+			else {
+				ReportFrame(slot);
+				slot.state.store(slot.task->error ? kSlotFree : kSlotReady, std::memory_order_release);
+			}
+		}
+
+		if (ended && !writing) {
+			for (auto& slot : slots) {
+				slot.task->ReleaseResult();
+			}
+			return false;
+		}
+		return true;
+	}
+
+	/*
+	* Called in main thread. Give back the frame taken by previous AcquireLatest, and take the newest ready one.
+	* @return Task holding the frame, nullptr if no frame is ready.
+	*/
+	FrameTask* AcquireLatest(int64_t* frame_number) {
+		ReleaseAcquired();
+		for (;;) {
+			int latest = -1;
+			int64_t latest_frame_number = -1;
+			for (size_t i = 0; i < slots.size(); i++) {
+				int64_t number = slots[i].frame_number.load(std::memory_order_relaxed);
+				if (slots[i].state.load(std::memory_order_acquire) == kSlotReady && number > latest_frame_number) {
+					latest = (int)i;
+					latest_frame_number = number;
+				}
+			}
+			if (latest < 0) {
+				return nullptr;
+			}
+			//Render thread might have started writing to it meanwhile, look again then.
+			int expected = kSlotReady;
+			if (slots[latest].state.compare_exchange_strong(expected, kSlotAcquired, std::memory_order_acq_rel)) {
+				acquired_slot = latest;
+				*frame_number = slots[latest].frame_number.load(std::memory_order_relaxed);
+				return slots[latest].task.get();
+			}
+		}
+	}
+
+	/*
+	* Called in main thread. The frame taken by AcquireLatest could be overwritten after this.
+	*/
+	void ReleaseAcquired() {
+		if (acquired_slot >= 0) {
+			slots[acquired_slot].state.store(kSlotReady, std::memory_order_release);
+			acquired_slot = -1;
+		}
+	}
+
+private:
+	/*
+	* Tell native consumer about a finished frame, before main thread could acquire it.
+	*/
+	void ReportFrame(const Slot& slot) {
+		ReadbackCompletionCallback callback = nullptr;
+		void* user_data = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(completion_mutex);
+			callback = completion_callback;
+			user_data = completion_user_data;
+		}
+		if (callback != nullptr) {
+			CallCompletion(callback, user_data, *slot.task, handle, FinishedStateOf(slot.task.get()),
+				slot.frame_number.load(std::memory_order_relaxed));
+		}
+	}
+
+	void Capture() {
+		Slot* target = nullptr;
+		for (auto& slot : slots) {
+			if (slot.state.load(std::memory_order_acquire) == kSlotFree) {
+				target = &slot;
+				break;
+			}
+		}
+		if (target == nullptr) {
+			Slot* oldest = nullptr;
+			for (auto& slot : slots) {
+				if (slot.state.load(std::memory_order_acquire) == kSlotReady
+					&& (oldest == nullptr || slot.frame_number.load(std::memory_order_relaxed) < oldest->frame_number.load(std::memory_order_relaxed))) {
+					oldest = &slot;
+				}
+			}
+			int expected = kSlotReady;
+			if (oldest == nullptr || !oldest->state.compare_exchange_strong(expected, kSlotWriting, std::memory_order_acq_rel)) {
+				//Every slot is busy, skip this frame.
+				return;
+			}
+			target = oldest;
+		}
+		target->state.store(kSlotWriting, std::memory_order_release);
+
+		target->task->Reset();
+		target->frame_number.store(next_frame_number++, std::memory_order_relaxed);
+		target->task->StartRequest();
+		if (target->task->done) {
+			target->state.store(kSlotFree, std::memory_order_release);
+		}
+	}
+};
+
+/*
+* Thread with a context shared with Unity's, blocking on fences of running tasks, so they're finished as soon as gpu is done,
+* instead of on next UpdateRenderThread. Only tasks whose OffThreadFence() isn't 0 are sent here.
+* Start, Push, Stop and TakeReturned are called in render thread.
+*/
+struct ReadbackThread {
+	// Wait for a fence this long at most, before checking if thread should stop.
+	static const GLuint64 kWaitTimeoutNs = 1000000;
+
+	ReadbackThread() :
+		stopping(false),
+		failed(false)
+	{
+
+	}
+
+	~ReadbackThread() {
+		// Plugin could be unloaded without a device shutdown, a joinable thread must not be destroyed.
+		std::deque<std::shared_ptr<BaseTask>> unfinished;
+		Stop(&unfinished);
+	}
+
+	bool Running() const {
+		return thread.joinable();
+	}
+
+	/*
+	* Set up shared context and start the thread. Unity's context must be current.
+	*/
+	bool Start() {
+		if (!context.Create()) {
+			context.Destroy();
+			return false;
+		}
+		stopping = false;
+		failed = false;
+		thread = std::thread(&ReadbackThread::Loop, this);
+		return true;
+	}
+
+	/*
+	* The context couldn't be made current in thread, it should be stopped.
+	*/
+	bool Failed() const {
+		return failed;
+	}
+
+	/*
+	* Hand over a running task. Its fence must have been flushed, this context can't flush it.
+	*/
+	void Push(const std::shared_ptr<BaseTask>& task) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(task);
+		}
+		task_available.notify_one();
+	}
+
+	/*
+	* Join the thread, and append the tasks it hasn't finished to unfinished, in order.
+	*/
+	void Stop(std::deque<std::shared_ptr<BaseTask>>* unfinished) {
+		if (!Running()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		task_available.notify_one();
+		thread.join();
+		context.Destroy();
+		TakeReturned(unfinished);
+		unfinished->insert(unfinished->end(), queue.begin(), queue.end());
+		queue.clear();
+	}
+
+	/*
+	* Take tasks whose fence couldn't be waited for in thread. Render thread finishes them instead, e.g. with an error.
+	*/
+	void TakeReturned(std::deque<std::shared_ptr<BaseTask>>* unfinished) {
+		std::lock_guard<std::mutex> lock(mutex);
+		unfinished->insert(unfinished->end(), returned.begin(), returned.end());
+		returned.clear();
+	}
+
+private:
+	void Loop() {
+		if (!context.MakeCurrent()) {
+			failed = true;
+			return;
+		}
+		for (;;) {
+			std::shared_ptr<BaseTask> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				task_available.wait(lock, [this] { return stopping || !queue.empty(); });
+				if (stopping) {
+					break;
+				}
+				task = queue.front();
+			}
+
+			// Fences signal in submission order, so waiting for the oldest one first loses nothing.
+			GLenum result = GL_TIMEOUT_EXPIRED;
+			while (result == GL_TIMEOUT_EXPIRED && !stopping) {
+				result = glClientWaitSync(task->OffThreadFence(), 0, kWaitTimeoutNs);
+			}
+			if (result == GL_TIMEOUT_EXPIRED) {
+				break;
+			}
+
+			// Update would give back staging memory if fence can't be queried, which only render thread could do.
+			GLint status = 0;
+			GLsizei length = 0;
+			if (result != GL_WAIT_FAILED) {
+				glGetSynciv(task->OffThreadFence(), GL_SYNC_STATUS, sizeof(GLint), &length, &status);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				queue.pop_front();
+				if (length <= 0 || status != GL_SIGNALED) {
+					returned.push_back(task);
+					continue;
+				}
+			}
+			// Fence is signaled, so Update finishes it without touching anything of render thread.
+			// Not under mutex, completion callback could be slow and render thread takes mutex every frame.
+			task->Update();
+			TaskState state = FinishedStateOf(task.get());
+			ReportCompletion(task.get(), state);
+			tasks.SetState(task->event_id, kTaskStateRunning, state);
+			offthread_finished_tasks.Push(task->event_id);
+		}
+		context.Release();
+	}
+
+	SharedContext context;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable task_available;
+	//Guarded by mutex. Tasks waiting for their fence, oldest first, and ones to give back to render thread.
+	std::deque<std::shared_ptr<BaseTask>> queue;
+	std::deque<std::shared_ptr<BaseTask>> returned;
+	std::atomic<bool> stopping;
+	std::atomic<bool> failed;
+};
+
+static ReadbackThread readback_thread;
+
+/*
+* Start or stop readback thread as main thread asked. Called in render thread.
+* Tasks it hasn't finished are polled by render thread again.
+*/
+static void UpdateReadbackThread() {
+	if (readback_thread.Running() && readback_thread.Failed()) {
+		readback_thread_failed = true;
+	}
+	bool wanted = readback_thread_wanted && !readback_thread_failed;
+	if (readback_thread.Running() && !wanted) {
+		readback_thread.Stop(&running_tasks);
+	}
+	else if (!readback_thread.Running() && wanted) {
+		readback_thread_failed = !readback_thread.Start();
+	}
+	readback_thread.TakeReturned(&running_tasks);
+}
+
 /**
  * Unity plugin load event
  */
@@ -291,6 +1506,7 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
 	if (CheckCompatible()) {
 		inited = true;
 		glewInit();
+		use_texture_sub_image = (GLEW_ARB_get_texture_sub_image || GLEW_VERSION_4_5) && glGetTextureSubImage != nullptr;
 	}
 }
 
@@ -300,6 +1516,8 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginUnload()
 {
 	graphics->UnregisterDeviceEventCallback(OnGraphicsDeviceEvent);
+	readback_thread.Stop(&running_tasks);
+	copy_workers.Stop();
 }
 
 /**
@@ -316,6 +1534,14 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
 	// Cleanup graphics API implementation upon shutdown
 	if (eventType == kUnityGfxDeviceEventShutdown)
 	{
+		if (renderer == kUnityGfxRendererOpenGLCore) {
+			readback_thread.Stop(&running_tasks);
+			staging_ring.Destroy();
+			staging_ring_attempted_size = 0;
+			pbo_pool.Clear();
+			framebuffer_cache.Clear();
+			texture_info_cache.Clear();
+		}
 		renderer = kUnityGfxRendererNull;
 	}
 }
@@ -329,16 +1555,233 @@ extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CheckCompatible() {
 	return (renderer == kUnityGfxRendererOpenGLCore);
 }
 
-int InsertEvent(std::shared_ptr<BaseTask> task) {
-	int event_id = next_event_id;
-	next_event_id++;
+/*
+* Move commands waiting in backlog to render thread, as long as there's room. Called in main thread.
+*/
+static void FlushRenderCommandBacklog() {
+	while (!render_command_backlog.empty() && render_commands.Push(render_command_backlog.front())) {
+		render_command_backlog.pop_front();
+	}
+}
 
-	std::lock_guard<std::mutex> guard(tasks_mutex);
-	tasks[event_id] = task;
+/*
+* Queue a command to render thread, called in main thread.
+* If the queue is full because render thread hasn't run for a while, the command waits in backlog, order is kept.
+*/
+static void PushRenderCommand(const RenderCommand& command) {
+	FlushRenderCommandBacklog();
+	if (!render_command_backlog.empty() || !render_commands.Push(command)) {
+		render_command_backlog.push_back(command);
+	}
+}
 
+static void PushRenderCommand(RenderCommand::Type type, const std::shared_ptr<BaseTask>& task, GLuint texture = 0, const std::shared_ptr<TextureStream>& stream = nullptr) {
+	RenderCommand command;
+	command.type = type;
+	command.task = task;
+	command.texture = texture;
+	command.stream = stream;
+	PushRenderCommand(command);
+}
+
+// Returned by request functions instead of an event_id, when the request is not made.
+static const int kRequestTooManyTasks = 0;
+static const int kRequestOverBudget = -1;
+static const int kRequestInvalid = -2;	//Unknown kind of ReadbackRequestDesc.
+
+/*
+* Whether the in-flight budget is used up, so no new request is accepted. Called in any thread.
+*/
+static bool InFlightBudgetUsedUp() {
+	uint64_t budget = in_flight_byte_budget;
+	return budget != 0 && in_flight_bytes >= budget;
+}
+
+/*
+* Register task and send it to render thread, called in main thread.
+* @return event_id of the task, kRequestTooManyTasks if there're too many tasks alive,
+* or kRequestOverBudget if the in-flight budget is already used up.
+*/
+int InsertEvent(std::shared_ptr<BaseTask> task) {
+	if (InFlightBudgetUsedUp()) {
+		return kRequestOverBudget;
+	}
+	int event_id = tasks.Insert(task);
+	if (event_id != 0) {
+		task->event_id = event_id;
+		PushRenderCommand(RenderCommand::kSubmit, task);
+	}
 	return event_id;
 }
 
+/*
+* Get a task that is done or ended without data. Main thread owns such tasks.
+*/
+static std::shared_ptr<BaseTask> GetFinishedTask(int event_id) {
+	TaskState state = tasks.GetState(event_id);
+	if (!IsFinishedState(state)) {
+		return nullptr;
+	}
+	return tasks.Get(event_id, state);
+}
+
+/*
+* Value of mailbox_texture for a new task reading texture. Called in main thread.
+*/
+static GLuint MailboxOf(GLuint texture) {
+	return mailbox_textures.count(texture) != 0 ? texture : 0;
+}
+
+/*
+* Forget a finished task of a mailbox texture. If it's done, older ones still running are superseded,
+* so they're dropped without mapping their result, and chunks they haven't started are skipped. Called in render thread.
+*/
+static void SupersedeOlderMailboxTasks(BaseTask* task, TaskState state) {
+	auto it = running_mailbox_tasks.find(task->mailbox_texture);
+	if (it == running_mailbox_tasks.end()) {
+		return;
+	}
+	auto& running = it->second;
+	for (auto ite = running.begin(); ite != running.end(); ++ite) {
+		if (ite->get() != task) {
+			continue;
+		}
+		if (state == kTaskStateDone) {
+			for (auto older = running.begin(); older != ite; ++older) {
+				(*older)->superseded = true;
+			}
+		}
+		running.erase(ite);
+		break;
+	}
+	if (running.empty()) {
+		running_mailbox_tasks.erase(it);
+	}
+}
+
+/*
+* Hand task over to main thread if it has finished. Called in render thread.
+* @return true if it's finished.
+*/
+static bool PublishIfFinished(BaseTask* task, TaskState from) {
+	if (!task->done) {
+		return false;
+	}
+	TaskState to = FinishedStateOf(task);
+	ReportCompletion(task, to);
+	tasks.SetState(task->event_id, from, to);
+	if (task->mailbox_texture != 0) {
+		SupersedeOlderMailboxTasks(task, to);
+	}
+	finished_task_backlog.push_back(task->event_id);
+	return true;
+}
+
+static void StartSubmitted(const std::shared_ptr<BaseTask>& task);
+static void StartBatch(const std::vector<int>& event_ids);
+
+/*
+* Process everything main thread sent, called in render thread.
+* Tasks and batches whose kickstart event already ran are started right away.
+*/
+static void DrainRenderCommands() {
+	RenderCommand command;
+	while (render_commands.Pop(&command)) {
+		switch (command.type) {
+		case RenderCommand::kSubmit:
+			if (early_kickstarts.erase(command.task->event_id) != 0) {
+				StartSubmitted(command.task);
+			}
+			else {
+				submitted_tasks[command.task->event_id] = command.task;
+			}
+			break;
+		case RenderCommand::kRelease:
+			command.task->ReleaseResult();
+			break;
+		case RenderCommand::kInvalidateTexture:
+			framebuffer_cache.Invalidate(command.texture);
+			texture_info_cache.Invalidate(command.texture);
+			break;
+		case RenderCommand::kBeginStream:
+			active_streams.push_back(command.stream);
+			break;
+		case RenderCommand::kEndStream:
+			command.stream->ended = true;
+			break;
+		case RenderCommand::kSubmitBatch:
+			if (early_batch_kickstarts.erase(command.batch_id) != 0) {
+				StartBatch(*command.batch);
+			}
+			else {
+				submitted_batches[command.batch_id] = command.batch;
+			}
+			break;
+		}
+	}
+}
+
+/*
+* Tell main thread about finished tasks, called in render thread.
+*/
+static void FlushFinishedTasks() {
+	size_t sent = 0;
+	while (sent < finished_task_backlog.size() && finished_tasks.Push(finished_task_backlog[sent])) {
+		sent++;
+	}
+	finished_task_backlog.erase(finished_task_backlog.begin(), finished_task_backlog.begin() + sent);
+}
+
+/**
+ * @brief Parameters of one request, in a batch or a render event. Layout is shared with C# side.
+ */
+struct ReadbackRequestDesc {
+	enum Kind : int32_t {
+		kTexture = 0,
+		kComputeBuffer = 1,
+	};
+	int32_t kind;
+	GLuint object;	//Texture or compute buffer.
+	int32_t miplevel;
+	int32_t x, y, z;	//Region of texture level, a size of 0 means up to the end of level.
+	int32_t width, height, depth;
+	int64_t offset, size;	//Range of compute buffer.
+};
+
+/*
+* Create the task reading a region of texture level, without registering it.
+*/
+static std::shared_ptr<FrameTask> MakeFrameTask(GLuint texture, int miplevel, int x, int y, int z, int width, int height, int depth) {
+	std::shared_ptr<FrameTask> task = std::make_shared<FrameTask>();
+	task->texture = texture;
+	task->miplevel = miplevel;
+	task->x = x;
+	task->y = y;
+	task->z = z;
+	task->width = width;
+	task->height = height;
+	task->depth = depth;
+	return task;
+}
+
+/*
+* Create the task of desc, without registering it. Called in any thread, latest-frame-only mailbox is left to caller.
+* @return nullptr if kind of desc is unknown.
+*/
+static std::shared_ptr<BaseTask> MakeTask(const ReadbackRequestDesc& desc) {
+	switch (desc.kind) {
+	case ReadbackRequestDesc::kTexture:
+		return MakeFrameTask(desc.object, desc.miplevel, desc.x, desc.y, desc.z, desc.width, desc.height, desc.depth);
+	case ReadbackRequestDesc::kComputeBuffer: {
+		std::shared_ptr<SsboTask> task = std::make_shared<SsboTask>();
+		task->Init(desc.object, (GLsizeiptr)desc.size, (GLintptr)desc.offset);
+		return task;
+	}
+	default:
+		return nullptr;
+	}
+}
+
 /**
 * @brief Init of the make request action.
 * You then have to call makeRequest_renderThread
@@ -352,16 +1795,185 @@ extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureMainThre
 	std::shared_ptr<FrameTask> task = std::make_shared<FrameTask>();
 	task->texture = texture;
 	task->miplevel = miplevel;
+	task->mailbox_texture = MailboxOf(texture);
 	return InsertEvent(task);
 }
 
-extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestComputeBufferMainThread(GLuint computeBuffer, GLint bufferSize) {
+/**
+* @brief Same as RequestTextureMainThread, but only read back a region of the level.
+* Matches Unity's AsyncGPUReadback.Request(texture, mip, x, width, y, height, z, depth).
+*
+* @param x, y, z Origin of the region, in texels of the level.
+* @param width, height, depth Size of the region, 0 means up to the end of the level.
+*/
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureRegionMainThread(GLuint texture, int miplevel, int x, int y, int z, int width, int height, int depth) {
+	// Create the task
+	std::shared_ptr<FrameTask> task = MakeFrameTask(texture, miplevel, x, y, z, width, height, depth);
+	task->mailbox_texture = MailboxOf(texture);
+	return InsertEvent(task);
+}
+
+/**
+* @brief Same as RequestTextureRegionMainThread, with info of the level already known by the requester,
+* so render thread doesn't need to query it from driver.
+*
+* @param info Target, size and internal format of the level. Layout is shared with C# side.
+*/
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureRegionWithInfoMainThread(GLuint texture, int miplevel, int x, int y, int z, int width, int height, int depth, const TextureLevelInfo* info) {
+	// Create the task
+	std::shared_ptr<FrameTask> task = MakeFrameTask(texture, miplevel, x, y, z, width, height, depth);
+	task->mailbox_texture = MailboxOf(texture);
+	task->level_info = *info;
+	task->has_level_info = true;
+	return InsertEvent(task);
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestComputeBufferMainThread(GLuint computeBuffer, int64_t bufferSize) {
 	// Create the task
 	std::shared_ptr<SsboTask> task = std::make_shared<SsboTask>();
-	task->Init(computeBuffer, bufferSize);
+	task->Init(computeBuffer, (GLsizeiptr)bufferSize);
 	return InsertEvent(task);
 }
 
+/**
+* @brief Same as RequestComputeBufferMainThread, but only read back size bytes starting at offset.
+* Matches Unity's AsyncGPUReadback.Request(buffer, size, offset).
+*/
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestComputeBufferRangeMainThread(GLuint computeBuffer, int64_t offset, int64_t size) {
+	// Create the task
+	std::shared_ptr<SsboTask> task = std::make_shared<SsboTask>();
+	task->Init(computeBuffer, (GLsizeiptr)size, (GLintptr)offset);
+	return InsertEvent(task);
+}
+
+
+/**
+ * @brief Make every request of descs, and start them all with one kickstart event and one fence.
+ * Call KickstartBatchInRenderThread via GL.IssuePluginEvent with the returned batch id.
+ *
+ * @param event_ids Receives event_id of each request, or what a single request function would return if it's not made, kRequestInvalid if kind is unknown.
+ * @return id of the batch for the kickstart event, 0 if no request is made.
+ */
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestBatchMainThread(const ReadbackRequestDesc* descs, int count, int* event_ids) {
+	std::shared_ptr<std::vector<int>> batch = std::make_shared<std::vector<int>>();
+	batch->reserve(count > 0 ? count : 0);
+	for (int i = 0; i < count; i++) {
+		std::shared_ptr<BaseTask> task = MakeTask(descs[i]);
+		if (task == nullptr) {
+			event_ids[i] = kRequestInvalid;
+			continue;
+		}
+		if (descs[i].kind == ReadbackRequestDesc::kTexture) {
+			task->mailbox_texture = MailboxOf(descs[i].object);
+		}
+		event_ids[i] = InsertEvent(task);
+		if (event_ids[i] > 0) {
+			batch->push_back(event_ids[i]);
+		}
+	}
+	if (batch->empty()) {
+		return 0;
+	}
+
+	RenderCommand command;
+	command.type = RenderCommand::kSubmitBatch;
+	command.batch_id = next_batch_handle;
+	command.batch = batch;
+	next_batch_handle = next_batch_handle == INT32_MAX ? 1 : next_batch_handle + 1;
+	PushRenderCommand(command);
+	return command.batch_id;
+}
+
+/**
+* @brief Same as RequestTextureMainThread, but result is written into caller-provided memory when the request is done.
+* GetData then returns the destination pointer. The request fails if result is larger than capacity.
+*
+* @param destination Memory to write to, must stay valid until the request is done.
+* @param capacity Size of destination in bytes.
+*/
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureIntoMainThread(GLuint texture, int miplevel, void* destination, uint64_t capacity) {
+	// Create the task
+	std::shared_ptr<FrameTask> task = std::make_shared<FrameTask>();
+	task->texture = texture;
+	task->miplevel = miplevel;
+	task->mailbox_texture = MailboxOf(texture);
+	task->destination = static_cast<char*>(destination);
+	task->destination_capacity = (size_t)capacity;
+	return InsertEvent(task);
+}
+
+/**
+* @brief Same as RequestComputeBufferMainThread, but result is written into caller-provided memory when the request is done.
+* GetData then returns the destination pointer. The request fails if result is larger than capacity.
+*
+* @param destination Memory to write to, must stay valid until the request is done.
+* @param capacity Size of destination in bytes.
+*/
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestComputeBufferIntoMainThread(GLuint computeBuffer, int64_t bufferSize, void* destination, uint64_t capacity) {
+	// Create the task
+	std::shared_ptr<SsboTask> task = std::make_shared<SsboTask>();
+	task->Init(computeBuffer, (GLsizeiptr)bufferSize);
+	task->destination = static_cast<char*>(destination);
+	task->destination_capacity = (size_t)capacity;
+	return InsertEvent(task);
+}
+
+/*
+* Publish a task just started if it's finished already, or keep it running, in render thread or readback thread.
+* Called in render thread.
+*/
+static void HandOffStarted(const std::shared_ptr<BaseTask>& task) {
+	if (PublishIfFinished(task.get(), kTaskStatePending)) {
+		return;
+	}
+	tasks.SetState(task->event_id, kTaskStatePending, kTaskStateRunning);
+	if (readback_thread.Running() && task->OffThreadFence() != 0) {
+		// Make sure the fence reaches gpu, readback thread can't flush Unity's context.
+		glFlush();
+		readback_thread.Push(task);
+		return;
+	}
+	running_tasks.push_back(task);
+	// Only the newest result of a mailbox texture is kept, older ones are superseded once it's done.
+	if (task->mailbox_texture != 0) {
+		running_mailbox_tasks[task->mailbox_texture].push_back(task);
+	}
+}
+
+/*
+* Start a task main thread submitted, called in render thread.
+* It waits behind deferred ones, so the per-frame budget goes to requests in submission order.
+*/
+static void StartSubmitted(const std::shared_ptr<BaseTask>& task) {
+	task->may_defer = true;
+	if (!deferred_tasks.empty()) {
+		deferred_tasks.push_back(task);
+		return;
+	}
+	task->StartRequest();
+	if (task->deferred) {
+		deferred_tasks.push_back(task);
+		return;
+	}
+	HandOffStarted(task);
+}
+
+/*
+* Start deferred tasks as long as the per-frame budget allows, called in render thread once running tasks had their chunks issued.
+*/
+static void StartDeferredTasks() {
+	while (!deferred_tasks.empty()) {
+		std::shared_ptr<BaseTask> task = deferred_tasks.front();
+		task->deferred = false;
+		task->StartRequest();
+		if (task->deferred) {
+			return;
+		}
+		deferred_tasks.pop_front();
+		HandOffStarted(task);
+	}
+}
+
 /**
  * @brief Create a a read texture request
  * Has to be called by GL.IssuePluginEvent
@@ -369,82 +1981,297 @@ extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestComputeBufferMa
  */
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API KickstartRequestInRenderThread(int event_id) {
 	// Get task back
-	std::lock_guard<std::mutex> guard(tasks_mutex);
-	std::shared_ptr<BaseTask> task = tasks[event_id];
-	task->StartRequest();
-	// Done init
-	task->initialized = true;
+	DrainRenderCommands();
+	auto ite = submitted_tasks.find(event_id);
+	if (ite == submitted_tasks.end()) {
+		// Its submit command is still in main thread's backlog, start it when it arrives.
+		if (tasks.GetState(event_id) == kTaskStatePending) {
+			early_kickstarts.insert(event_id);
+		}
+		return;
+	}
+	std::shared_ptr<BaseTask> task = ite->second;
+	submitted_tasks.erase(ite);
+
+	StartSubmitted(task);
+	FlushFinishedTasks();
+}
+
+/**
+ * @brief Start every task of a batch made by RequestBatchMainThread, with one fence after all their copies.
+ * Has to be called by GL.IssuePluginEvent
+ * @param batch_id given by RequestBatchMainThread
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API KickstartBatchInRenderThread(int batch_id) {
+	DrainRenderCommands();
+	auto it = submitted_batches.find(batch_id);
+	if (it == submitted_batches.end()) {
+		if (batch_id > 0) {
+			early_batch_kickstarts.insert(batch_id);
+		}
+		return;
+	}
+	std::shared_ptr<std::vector<int>> event_ids = it->second;
+	submitted_batches.erase(it);
+
+	StartBatch(*event_ids);
+	FlushFinishedTasks();
+}
+
+/*
+* Start tasks of a batch, with one fence after all their copies. Called in render thread.
+*/
+static void StartBatch(const std::vector<int>& event_ids) {
+	std::vector<std::shared_ptr<BaseTask>> started;
+	started.reserve(event_ids.size());
+	for (int event_id : event_ids) {
+		auto ite = submitted_tasks.find(event_id);
+		if (ite == submitted_tasks.end()) {
+			continue;
+		}
+		std::shared_ptr<BaseTask> task = ite->second;
+		submitted_tasks.erase(ite);
+		task->in_batch = true;
+		task->StartRequest();
+		started.push_back(task);
+	}
+
+	// One fence covers every copy issued above, made only if some task waits for it.
+	std::shared_ptr<SharedFence> fence;
+	for (auto& task : started) {
+		if (task->AdoptFence(nullptr)) {
+			fence = std::make_shared<SharedFence>(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+			break;
+		}
+	}
+	if (fence != nullptr) {
+		for (auto& task : started) {
+			task->AdoptFence(fence);
+		}
+	}
+	for (auto& task : started) {
+		HandOffStarted(task);
+	}
+}
+
+extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetKickstartBatchFunctionPtr() {
+	return KickstartBatchInRenderThread;
 }
 
 extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetKickstartFunctionPtr() {
 	return KickstartRequestInRenderThread;
 }
 
+/**
+ * @brief Parameters of requests made by render events, see RequestInRenderThread. Layout is shared with C# side.
+ * The memory is owned by caller, and must stay alive as long as an event using it could run.
+ */
+struct ReadbackEventData {
+	ReadbackRequestDesc request;
+	void* destination;	//Caller-provided memory to read into, null to read into staging memory.
+	uint64_t destination_capacity;
+	//Written by render thread each time the event runs: event_id of the request made, or what a request function would return if it's not, kRequestInvalid if kind is unknown.
+	int32_t event_id;
+};
+
+/**
+ * @brief Make a request and start it right away, in render thread. Called by GL.IssuePluginEventAndData or
+ * CommandBuffer.IssuePluginEventAndData, so the copy happens at that exact point of the frame, every time the event runs.
+ * Main thread does nothing for it, the event_id is found in data afterwards. Latest-frame-only mode doesn't apply.
+ *
+ * @param eventId Unused.
+ * @param data A ReadbackEventData.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestInRenderThread(int eventId, void* data) {
+	unused(eventId);
+	ReadbackEventData* event_data = static_cast<ReadbackEventData*>(data);
+	DrainRenderCommands();
+
+	std::shared_ptr<BaseTask> task = MakeTask(event_data->request);
+	if (task == nullptr) {
+		event_data->event_id = kRequestInvalid;
+		return;
+	}
+	task->destination = static_cast<char*>(event_data->destination);
+	task->destination_capacity = (size_t)event_data->destination_capacity;
+
+	if (InFlightBudgetUsedUp()) {
+		event_data->event_id = kRequestOverBudget;
+		return;
+	}
+	int event_id = tasks.Insert(task);
+	event_data->event_id = event_id;
+	if (event_id == 0) {
+		return;
+	}
+	task->event_id = event_id;
+	task->StartRequest();
+	HandOffStarted(task);
+	FlushFinishedTasks();
+}
+
+extern "C" UnityRenderingEventAndData UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRequestInRenderThreadFunctionPtr() {
+	return RequestInRenderThread;
+}
+
 /**
 * Update all current available tasks. Should be called in render thread.
  */
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UpdateRenderThread(int event_id) {
 	unused(event_id);
-	//Lock up.
-	std::lock_guard<std::mutex> guard(tasks_mutex);
-	for (auto ite = tasks.begin(); ite != tasks.end(); ite++) {
-		auto task = ite->second;
-		if (task != nullptr && task->initialized && !task->done)
-			task->Update();
+
+	//Pick up new tasks, and give back staging memory of results that main thread is done with.
+	DrainRenderCommands();
+	UpdateReadbackThread();
+
+	frame_transferred_bytes = 0;
+	frame_chunk_issued = false;
+
+	//Poll from the oldest task, until the first one that's not finished.
+	//Every later fence can't have signaled either, so gl queries stay O(finished + throttled + 1).
+	//Throttled tasks are still updated after that, they have chunks to start, which get the per-frame budget in submission order.
+	bool waiting = false;
+	for (auto it = running_tasks.begin(); it != running_tasks.end();) {
+		BaseTask* task = it->get();
+		if (waiting && !task->Throttled()) {
+			++it;
+			continue;
+		}
+		task->Update();
+		if (PublishIfFinished(task, kTaskStateRunning)) {
+			it = running_tasks.erase(it);
+			continue;
+		}
+		waiting = waiting || !task->Throttled();
+		++it;
 	}
+	//Tasks still waiting to start are newer than throttled ones, so they get what's left of the budget after their chunks.
+	StartDeferredTasks();
+	FlushFinishedTasks();
+
+	//Capture every stream, and drop ended ones gpu is done with.
+	size_t kept = 0;
+	for (size_t i = 0; i < active_streams.size(); i++) {
+		if (active_streams[i]->Update()) {
+			active_streams[kept++] = active_streams[i];
+		}
+	}
+	active_streams.resize(kept);
+
+	pbo_pool.Trim();
+	framebuffer_cache.Trim();
+	texture_info_cache.Trim();
 }
 
 extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetUpdateRenderThreadFunctionPtr() {
 	return UpdateRenderThread;
 }
 
+/*
+* Called in main thread when a task of a mailbox texture finishes. Count it if it's dropped by render thread.
+* If it's done, older results of the same texture nobody has read yet are disposed right away.
+*/
+static void DropOlderMailboxResults(BaseTask* task) {
+	auto counter = mailbox_textures.find(task->mailbox_texture);
+	if (tasks.GetState(task->event_id) == kTaskStateDropped) {
+		if (counter != mailbox_textures.end())
+			counter->second++;
+		return;
+	}
+	if (tasks.GetState(task->event_id) != kTaskStateDone) {
+		return;
+	}
+
+	size_t kept = 0;
+	for (size_t i = 0; i < pending_release_tasks.size(); i++) {
+		int event_id = pending_release_tasks[i];
+		auto older = tasks.Get(event_id, kTaskStateDone);
+		if (older != nullptr && older->mailbox_texture == task->mailbox_texture && !older->leased && !older->read) {
+			tasks.Remove(event_id);
+			PushRenderCommand(RenderCommand::kRelease, older);
+			if (counter != mailbox_textures.end())
+				counter->second++;
+			continue;
+		}
+		pending_release_tasks[kept++] = event_id;
+	}
+	pending_release_tasks.resize(kept);
+}
+
 /**
 * Update in main thread.
 * This will erase tasks that are marked as done in last frame.
 * Also save tasks that are done this frame.
 * By doing this, all tasks are done for one frame, then removed.
+* Tasks whose data is leased by GetData are kept until ReleaseData.
  */
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UpdateMainThread() {
-	//Lock up.
-	std::lock_guard<std::mutex> guard(tasks_mutex);
-
-	//Remove tasks that are done in the last update.
-	for (auto& event_id : pending_release_tasks) {
-		auto t = tasks.find(event_id);
-		if (t != tasks.end()) {
-			tasks.erase(t);
+	//Commands that didn't fit last frame, e.g. a submit whose kickstart event is coming.
+	FlushRenderCommandBacklog();
+
+	//Remove tasks that are done in the last update. Leased ones are checked again next update.
+	size_t kept = 0;
+	for (size_t i = 0; i < pending_release_tasks.size(); i++) {
+		int event_id = pending_release_tasks[i];
+		auto task = GetFinishedTask(event_id);
+		if (task == nullptr) {
+			continue;
+		}
+		if (task->leased) {
+			pending_release_tasks[kept++] = event_id;
+			continue;
 		}
+		tasks.Remove(event_id);
+		PushRenderCommand(RenderCommand::kRelease, task);
 	}
-	pending_release_tasks.clear();
+	pending_release_tasks.resize(kept);
 
 	//Push new done tasks to pending list.
-	for (auto ite = tasks.begin(); ite != tasks.end(); ite++) {
-		auto task = ite->second;
-		if (task->done) {
-			pending_release_tasks.push_back(ite->first);
+	int event_id = 0;
+	while (finished_tasks.Pop(&event_id) || offthread_finished_tasks.Pop(&event_id)) {
+		auto task = GetFinishedTask(event_id);
+		if (task != nullptr && task->mailbox_texture != 0) {
+			DropOlderMailboxResults(task.get());
 		}
+		pending_release_tasks.push_back(event_id);
 	}
 }
 
 /**
  * @brief Get data from the main thread.
- * The data owner is still native plugin, outside caller should copy the data asap to avoid any problem.
- * 
+ * The pointer points directly into the staging memory that gpu wrote to, no copy is made.
+ * The data is leased to caller, it stays valid until ReleaseData is called with the same event_id.
+ * The data owner is still native plugin.
  */
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetData(int event_id, void** buffer, size_t* length) {
-	// Get task back
-	std::lock_guard<std::mutex> guard(tasks_mutex);
-	std::shared_ptr<BaseTask> task = tasks[event_id];
-
-	// Do something only if initialized (thread safety)
-	if (!task->done) {
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetData(int event_id, void** buffer, uint64_t* length) {
+	// Get task back, do something only if it's done (thread safety)
+	std::shared_ptr<BaseTask> task = tasks.Get(event_id, kTaskStateDone);
+	if (task == nullptr) {
 		return;
 	}
 
 	// Return the pointer.
 	// The memory ownership doesn't transfer.
-	auto dataPtr = task->GetData(length);
+	size_t data_length = 0;
+	auto dataPtr = task->GetData(&data_length);
 	*buffer = dataPtr;
+	*length = data_length;
+	if (dataPtr != nullptr) {
+		task->leased = true;
+		task->read = true;
+	}
+}
+
+/**
+ * @brief End the lease taken by GetData. The data pointer must not be used after next UpdateMainThread.
+ * The task is then disposed as usual, and its staging memory is recycled in render thread.
+ * @param event_id containing the the task index, given by makeRequest_mainThread
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseData(int event_id) {
+	std::shared_ptr<BaseTask> task = GetFinishedTask(event_id);
+	if (task != nullptr) {
+		task->leased = false;
+	}
 }
 
 /**
@@ -452,11 +2279,7 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetData(int event_id,
  * @param event_id containing the the task index, given by makeRequest_mainThread
  */
 extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TaskExists(int event_id) {
-	// Get task back
-	std::lock_guard<std::mutex> guard(tasks_mutex);
-	bool result = tasks.find(event_id) != tasks.end();
-
-	return result;
+	return tasks.GetState(event_id) != kTaskStateInvalid;
 }
 
 /**
@@ -464,24 +2287,281 @@ extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TaskExists(int event_
  * @param event_id containing the the task index, given by makeRequest_mainThread
  */
 extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TaskDone(int event_id) {
-	// Get task back
-	std::lock_guard<std::mutex> guard(tasks_mutex);
-	auto ite = tasks.find(event_id);
-	if (ite != tasks.end())
-		return ite->second->done;
+	TaskState state = tasks.GetState(event_id);
+	if (state != kTaskStateInvalid)
+		return IsFinishedState(state);
 	return true;	//If it's disposed, also assume it's done.
 }
 
+/**
+ * @brief Get states of many requests at once, instead of calling TaskDone/TaskError/TaskExists for each.
+ * @param ids event_ids given by makeRequest_mainThread
+ * @param count Number of ids
+ * @param outStates Receives one TaskState per id, kTaskStateInvalid(0) for unknown or disposed requests.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API QueryTaskStates(const int* ids, int count, uint8_t* outStates) {
+	for (int i = 0; i < count; i++) {
+		outStates[i] = tasks.GetState(ids[i]);
+	}
+}
+
+/**
+ * @brief Get the table of task states, so they could be read directly without calling into plugin.
+ * The table stays valid as long as the plugin is loaded.
+ * Entry (event_id & (capacity - 1)) is a 64 bit word, (event_id << 32 | state) if the request is alive.
+ * Any other value means the request doesn't exist anymore. Read each entry atomically.
+ * @param capacity Receives number of entries, which is a power of two.
+ */
+extern "C" const uint64_t* UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetTaskStateTable(int* capacity) {
+	static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && ATOMIC_LLONG_LOCK_FREE == 2,
+		"State table must be plain lock-free 64 bit words to be shared.");
+	*capacity = (int)TaskRegistry<BaseTask>::kCapacity;
+	return reinterpret_cast<const uint64_t*>(tasks.StateWords());
+}
+
 /**
  * @brief Check if request is in error
  * @param event_id containing the the task index, given by makeRequest_mainThread
  */
 extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TaskError(int event_id) {
-	// Get task back
-	std::lock_guard<std::mutex> guard(tasks_mutex);
-	auto ite = tasks.find(event_id);
-	if (ite != tasks.end())
-		return ite->second->error;
+	TaskState state = tasks.GetState(event_id);
+	if (state != kTaskStateInvalid)
+		return state >= kTaskStateError;	//Every state after it has no data either.
 
 	return true;	//It's disposed, assume as error.
-}
\ No newline at end of file
+}
+/**
+ * @brief Set size of the persistent mapped staging ring, 0 to disable it.
+ * It's recreated in render thread once it's not in use. Without ARB_buffer_storage, it's never used.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetStagingRingSize(uint64_t size) {
+	staging_ring_size = (size_t)size;
+}
+
+/**
+ * @brief Get statistics of the pbo pool, for profiling.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPboPoolStats(PboPoolStats* stats) {
+	*stats = pbo_pool.GetStats();
+}
+
+/**
+ * @brief Tell plugin a texture is about to be destroyed or reinitialized, so everything cached for it is dropped.
+ * Must be called if a texture changes size or format under the same name.
+ * Optional for destroyed textures, they're also found periodically. Called in main thread.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API InvalidateTexture(GLuint texture) {
+	PushRenderCommand(RenderCommand::kInvalidateTexture, nullptr, texture);
+}
+
+/**
+ * @brief Start capturing a texture level every frame, into a ring of ring_depth reused slots.
+ * A frame is captured in each render thread update, the latest one is got by AcquireLatestFrame.
+ * Latency is bounded by ring_depth frames. Use at least 3, as one slot is held by main thread while reading.
+ * @return Handle of the stream, 0 if ring_depth is less than 1.
+ */
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API BeginStream(GLuint texture, int miplevel, int ring_depth) {
+	if (ring_depth < 1) {
+		return 0;
+	}
+	std::shared_ptr<TextureStream> stream = std::make_shared<TextureStream>(texture, miplevel, ring_depth);
+	int handle = next_stream_handle++;
+	stream->handle = handle;
+	streams[handle] = stream;
+	PushRenderCommand(RenderCommand::kBeginStream, nullptr, 0, stream);
+	return handle;
+}
+
+/**
+ * @brief Get the newest captured frame of a stream. No copy is made, data points into staging memory.
+ * The data stays valid until next AcquireLatestFrame, ReleaseLatestFrame or EndStream of this stream.
+ * @param frame_number Receives number of the frame, counted from 0 since BeginStream. Same frame could be returned again.
+ * @return false if no frame is captured yet.
+ */
+extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AcquireLatestFrame(int stream_handle, void** buffer, uint64_t* length, int64_t* frame_number) {
+	auto it = streams.find(stream_handle);
+	if (it == streams.end()) {
+		return false;
+	}
+	FrameTask* task = it->second->AcquireLatest(frame_number);
+	if (task == nullptr) {
+		return false;
+	}
+	size_t data_length = 0;
+	*buffer = task->GetData(&data_length);
+	*length = data_length;
+	return *buffer != nullptr;
+}
+
+/**
+ * @brief Give back the frame taken by AcquireLatestFrame early, so its slot could be reused.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseLatestFrame(int stream_handle) {
+	auto it = streams.find(stream_handle);
+	if (it != streams.end()) {
+		it->second->ReleaseAcquired();
+	}
+}
+
+/**
+ * @brief See SetCompletionCallbackFunc in AsyncGPUReadbackCallbacks.h.
+ */
+extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetCompletionCallback(int event_id, ReadbackCompletionCallback callback, void* user_data) {
+	std::shared_ptr<BaseTask> task = tasks.GetAlive(event_id);
+	if (task == nullptr) {
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(completion_mutex);
+		task->completion_callback = callback;
+		task->completion_user_data = user_data;
+		if (!task->completion_reported || callback == nullptr) {
+			return true;
+		}
+	}
+
+	// Already finished, it's published right after being reported.
+	TaskState state = tasks.GetState(event_id);
+	while (!IsFinishedState(state)) {
+		std::this_thread::yield();
+		state = tasks.GetState(event_id);
+	}
+	ReadbackCompletion completion;
+	completion.handle = event_id;
+	completion.state = state;
+	size_t length = 0;
+	completion.data = task->GetData(&length);
+	completion.length = completion.data != nullptr ? length : 0;
+	task->GetExtent(&completion.width, &completion.height, &completion.depth);
+	completion.frame_number = -1;
+	callback(&completion, user_data);
+	return true;
+}
+
+/**
+ * @brief See SetStreamCompletionCallbackFunc in AsyncGPUReadbackCallbacks.h.
+ */
+extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetStreamCompletionCallback(int stream_handle, ReadbackCompletionCallback callback, void* user_data) {
+	auto it = streams.find(stream_handle);
+	if (it == streams.end()) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(completion_mutex);
+	it->second->completion_callback = callback;
+	it->second->completion_user_data = user_data;
+	return true;
+}
+
+static_assert(std::is_same<decltype(&SetCompletionCallback), SetCompletionCallbackFunc>::value &&
+	std::is_same<decltype(&SetStreamCompletionCallback), SetStreamCompletionCallbackFunc>::value,
+	"Exported callback functions must match their types in AsyncGPUReadbackCallbacks.h");
+
+/**
+ * @brief Stop capturing. Data of the stream must not be used anymore.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API EndStream(int stream_handle) {
+	auto it = streams.find(stream_handle);
+	if (it == streams.end()) {
+		return;
+	}
+	{
+		// Frames still in flight aren't reported anymore.
+		std::lock_guard<std::mutex> lock(completion_mutex);
+		it->second->completion_callback = nullptr;
+	}
+	PushRenderCommand(RenderCommand::kEndStream, nullptr, 0, it->second);
+	streams.erase(it);
+}
+
+/**
+ * @brief Turn the readback thread on or off, it's off by default. It uses a context shared with Unity's to wait for fences,
+ * so requests are done as soon as gpu finishes them, instead of on next update. Requests are still started in render thread.
+ * Stays off if a shared context can't be created.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetReadbackThread(bool enabled) {
+	readback_thread_wanted = enabled;
+}
+
+/**
+ * @brief Turn latest-frame-only mode of a texture on or off, for real-time consumers.
+ * Once a newer request of the texture is done, older ones still running are dropped,
+ * and older results nobody has read yet are disposed. Dropped requests end as done with error.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetLatestFrameOnly(GLuint texture, bool enabled) {
+	if (enabled)
+		mailbox_textures.insert(std::make_pair(texture, (uint64_t)0));
+	else
+		mailbox_textures.erase(texture);
+}
+
+/**
+ * @brief Number of requests of a latest-frame-only texture dropped since the mode is turned on.
+ */
+extern "C" uint64_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetDroppedFrameCount(GLuint texture) {
+	auto it = mailbox_textures.find(texture);
+	return it != mailbox_textures.end() ? it->second : 0;
+}
+
+/**
+ * @brief Limit staging memory held by running requests and results not consumed yet, 0 for unlimited.
+ * Over budget, new requests return kRequestOverBudget(-1) instead of an event_id,
+ * or end in kTaskStateOverBudget if the budget is used up by the time render thread starts them.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetInFlightByteBudget(uint64_t bytes) {
+	in_flight_byte_budget = bytes;
+}
+
+/**
+ * @brief Staging memory held by running requests and results not consumed yet, for throttling.
+ */
+extern "C" uint64_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetInFlightBytes() {
+	return in_flight_bytes;
+}
+
+/**
+ * @brief Get the part of result already available. While a chunked transfer is running, it grows chunk by chunk from the beginning.
+ * Otherwise the whole result is available once done, and is copied into caller-provided destination on first call. Unlike GetData, the data is not leased.
+ * @param length Receives number of bytes available, 0 if nothing is.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetAvailableData(int event_id, void** buffer, uint64_t* length) {
+	*buffer = nullptr;
+	*length = 0;
+	//A done result might not be copied out yet.
+	std::shared_ptr<BaseTask> task = tasks.Get(event_id, kTaskStateDone);
+	if (task != nullptr) {
+		size_t data_length = 0;
+		*buffer = task->GetData(&data_length);
+		*length = *buffer != nullptr ? data_length : 0;
+		if (*buffer != nullptr) {
+			task->read = true;
+		}
+		return;
+	}
+	task = tasks.Get(event_id, kTaskStateRunning);
+	if (task == nullptr) {
+		return;
+	}
+	uint64_t available = task->available_bytes.load(std::memory_order_acquire);
+	if (available != 0) {
+		*buffer = task->available_data.load(std::memory_order_acquire);
+		*length = available;
+	}
+}
+
+/**
+ * @brief Limit bytes copied out of gpu per frame, 0 for unlimited, which is the default.
+ * Requests over it stay pending until a later frame, larger transfers are tiled and spread across frames,
+ * so a huge readback doesn't stall the gpu for a whole frame. Batches, render event requests and streams are never held back.
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetFrameTransferBudget(uint64_t bytes) {
+	frame_transfer_budget = bytes;
+}
+
+/**
+ * @brief Set size of the chunks large transfers are split into, clamped to [1MB, 1GB].
+ */
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTransferChunkSize(uint64_t size) {
+	const uint64_t min_size = 1024 * 1024;
+	const uint64_t max_size = 1024 * 1024 * 1024;
+	transfer_chunk_size = (size_t)std::min(std::max(size, min_size), max_size);
+}
@@ -0,0 +1,177 @@
+#pragma once
+// Opengl includes
+#include <GL/glew.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Statistics of the pbo pool. Layout is shared with C# side.
+ */
+struct PboPoolStats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t allocated_bytes;
+	uint64_t idle_bytes;
+};
+
+/**
+ * @brief Pool of pixel pack buffers, bucketed by power-of-two size classes.
+ *
+ * Tasks borrow a buffer when starting a request, and give it back once its fence is retired,
+ * so the driver doesn't have to allocate and free a buffer for every readback.
+ * Idle buffers above the recent high-water mark of usage are trimmed periodically.
+ *
+ * All methods except GetStats() must be called in render thread.
+ */
+class PboPool {
+public:
+	// Smallest size class is 4KB.
+	static const int kMinClassBits = 12;
+	static const int kClassCount = (int)(sizeof(size_t) * 8);
+	// Trim idle buffers once every this many frames.
+	static const int kTrimIntervalFrames = 120;
+
+	PboPool() :
+		buckets(kClassCount),
+		hits(0),
+		misses(0),
+		allocated_bytes(0),
+		idle_bytes(0)
+	{
+
+	}
+
+	/**
+	 * @brief Borrow a buffer of at least size bytes.
+	 * @param capacity Receives the real size of the buffer, which should be passed back to Release.
+	 * @return The buffer name, or 0 if size is 0.
+	 */
+	GLuint Acquire(size_t size, size_t* capacity) {
+		if (size == 0) {
+			return 0;
+		}
+		int size_class = SizeClassOf(size);
+		size_t class_size = (size_t)1 << size_class;
+		*capacity = class_size;
+
+		in_use_bytes += class_size;
+		if (in_use_bytes > window_peak_bytes) {
+			window_peak_bytes = in_use_bytes;
+		}
+
+		auto& bucket = buckets[size_class];
+		if (!bucket.empty()) {
+			GLuint pbo = bucket.back();
+			bucket.pop_back();
+			idle_bytes -= class_size;
+			hits++;
+			return pbo;
+		}
+
+		misses++;
+		GLuint pbo = 0;
+		glGenBuffers(1, &pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, class_size, 0, GL_STREAM_READ);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		allocated_bytes += class_size;
+		return pbo;
+	}
+
+	/**
+	 * @brief Give back a buffer. Caller must make sure gpu is not using it anymore.
+	 */
+	void Release(GLuint pbo, size_t capacity) {
+		if (pbo == 0) {
+			return;
+		}
+		in_use_bytes -= capacity;
+		buckets[SizeClassOf(capacity)].push_back(pbo);
+		idle_bytes += capacity;
+	}
+
+	/**
+	 * @brief Delete a buffer that is not safe to reuse, e.g. its fence is lost.
+	 */
+	void Discard(GLuint pbo, size_t capacity) {
+		if (pbo == 0) {
+			return;
+		}
+		in_use_bytes -= capacity;
+		allocated_bytes -= capacity;
+		glDeleteBuffers(1, &pbo);
+	}
+
+	/**
+	 * @brief Called once per frame. Periodically delete idle buffers that are not needed to cover the peak usage of last period.
+	 */
+	void Trim() {
+		if (++frames_since_trim < kTrimIntervalFrames) {
+			return;
+		}
+		frames_since_trim = 0;
+
+		size_t allowed_idle = window_peak_bytes - in_use_bytes;
+		for (int i = kClassCount - 1; i >= 0 && idle_bytes > allowed_idle; i--) {
+			auto& bucket = buckets[i];
+			size_t class_size = (size_t)1 << i;
+			while (!bucket.empty() && idle_bytes > allowed_idle) {
+				GLuint pbo = bucket.back();
+				bucket.pop_back();
+				glDeleteBuffers(1, &pbo);
+				idle_bytes -= class_size;
+				allocated_bytes -= class_size;
+			}
+		}
+		window_peak_bytes = in_use_bytes;
+	}
+
+	/**
+	 * @brief Delete all idle buffers.
+	 */
+	void Clear() {
+		for (int i = 0; i < kClassCount; i++) {
+			auto& bucket = buckets[i];
+			if (!bucket.empty()) {
+				glDeleteBuffers((GLsizei)bucket.size(), bucket.data());
+				size_t bytes = bucket.size() << i;
+				idle_bytes -= bytes;
+				allocated_bytes -= bytes;
+				bucket.clear();
+			}
+		}
+	}
+
+	/**
+	 * @brief Could be called from any thread.
+	 */
+	PboPoolStats GetStats() const {
+		PboPoolStats stats;
+		stats.hits = hits;
+		stats.misses = misses;
+		stats.allocated_bytes = allocated_bytes;
+		stats.idle_bytes = idle_bytes;
+		return stats;
+	}
+
+private:
+	static int SizeClassOf(size_t size) {
+		int size_class = kMinClassBits;
+		while (size_class < kClassCount - 1 && ((size_t)1 << size_class) < size) {
+			size_class++;
+		}
+		return size_class;
+	}
+
+	std::vector<std::vector<GLuint>> buckets;
+	size_t in_use_bytes = 0;
+	size_t window_peak_bytes = 0;
+	int frames_since_trim = 0;
+
+	std::atomic<uint64_t> hits;
+	std::atomic<uint64_t> misses;
+	std::atomic<uint64_t> allocated_bytes;
+	std::atomic<uint64_t> idle_bytes;
+};
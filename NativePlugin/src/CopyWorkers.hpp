@@ -0,0 +1,169 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Completion of one copy submitted to CopyWorkers, which might be split into several pieces.
+ */
+struct CopyBatch {
+	std::atomic<size_t> pending_pieces;
+
+	CopyBatch() : pending_pieces(0) {}
+
+	bool Done() const {
+		return pending_pieces.load(std::memory_order_acquire) == 0;
+	}
+};
+
+/**
+ * @brief Small pool of threads copying readback results out of mapped staging memory,
+ * so large copies don't run on render thread, and scale with core count.
+ *
+ * A copy is split into pieces, which are picked up by any worker. Small copies are just done by caller.
+ * Threads are started on first use. Could be used from any thread.
+ */
+class CopyWorkers {
+public:
+	// Copies are split into pieces of this size, smaller ones are done by caller directly.
+	static const size_t kPieceSize = 4 * 1024 * 1024;
+	static const unsigned kMaxWorkers = 8;
+
+	~CopyWorkers() {
+		Stop();
+	}
+
+	/**
+	 * @brief Copy size bytes from src to dst. Both must stay valid until the returned batch is done.
+	 * @return Completion of the copy, nullptr if it's already done.
+	 */
+	std::shared_ptr<CopyBatch> Copy(char* dst, const char* src, size_t size) {
+		if (size < kPieceSize) {
+			std::memcpy(dst, src, size);
+			return nullptr;
+		}
+		std::shared_ptr<CopyBatch> batch = std::make_shared<CopyBatch>();
+		size_t piece_count = (size + kPieceSize - 1) / kPieceSize;
+		batch->pending_pieces = piece_count;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			StartIfNeeded();
+			for (size_t offset = 0; offset < size; offset += kPieceSize) {
+				Piece piece;
+				piece.dst = dst + offset;
+				piece.src = src + offset;
+				piece.size = std::min((size_t)kPieceSize, size - offset);
+				piece.batch = batch;
+				pieces.push_back(piece);
+			}
+		}
+		work_available.notify_all();
+		return batch;
+	}
+
+	/**
+	 * @brief Block until batch is done, doing queued pieces meanwhile instead of just waiting.
+	 */
+	void Wait(const std::shared_ptr<CopyBatch>& batch) {
+		if (batch == nullptr) {
+			return;
+		}
+		while (!batch->Done()) {
+			Piece piece;
+			if (TryTake(&piece)) {
+				Run(piece);
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	/**
+	 * @brief Copy using the workers and the calling thread together, and return once it's done.
+	 */
+	void CopyAndWait(char* dst, const char* src, size_t size) {
+		Wait(Copy(dst, src, size));
+	}
+
+	/**
+	 * @brief Finish queued pieces and join the threads. They're started again on next use.
+	 */
+	void Stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		work_available.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		threads.clear();
+		stopping = false;
+	}
+
+private:
+	struct Piece {
+		char* dst = nullptr;
+		const char* src = nullptr;
+		size_t size = 0;
+		std::shared_ptr<CopyBatch> batch;
+	};
+
+	// Called with mutex held.
+	void StartIfNeeded() {
+		if (!threads.empty()) {
+			return;
+		}
+		// Leave a core to main thread and one to render thread.
+		unsigned cores = std::thread::hardware_concurrency();
+		unsigned count = std::min((unsigned)kMaxWorkers, cores > 3 ? cores - 2 : 1u);
+		for (unsigned i = 0; i < count; i++) {
+			threads.push_back(std::thread(&CopyWorkers::WorkerLoop, this));
+		}
+	}
+
+	bool TryTake(Piece* piece) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pieces.empty()) {
+			return false;
+		}
+		*piece = pieces.front();
+		pieces.pop_front();
+		return true;
+	}
+
+	static void Run(const Piece& piece) {
+		std::memcpy(piece.dst, piece.src, piece.size);
+		piece.batch->pending_pieces.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	void WorkerLoop() {
+		for (;;) {
+			Piece piece;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				work_available.wait(lock, [this] { return stopping || !pieces.empty(); });
+				if (pieces.empty()) {
+					return;
+				}
+				piece = pieces.front();
+				pieces.pop_front();
+			}
+			Run(piece);
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable work_available;
+	std::deque<Piece> pieces;
+	std::vector<std::thread> threads;
+	bool stopping = false;
+};
@@ -0,0 +1,110 @@
+#pragma once
+// Opengl includes
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Small LRU cache of framebuffer objects used to read textures, keyed by texture, mip level and layer.
+ *
+ * Textures read every frame reuse the same fbo, instead of creating and deleting one per request.
+ * Entries of a texture are dropped by Invalidate() when it's known to be destroyed, and textures deleted
+ * behind our back are found by Trim() periodically, so their storage isn't kept alive by the attachment.
+ *
+ * Must be used in render thread.
+ */
+class FramebufferCache {
+public:
+	static const size_t kCapacity = 32;
+	// Look for deleted textures once every this many frames.
+	static const int kTrimIntervalFrames = 120;
+
+	/**
+	 * @brief Get the fbo for a layer of texture level, creating it or evicting the least recently used one if needed.
+	 * The texture is not attached, caller should attach it every time, as Unity might have reused the name for a new texture.
+	 */
+	GLuint Get(GLuint texture, int miplevel, int layer) {
+		use_count++;
+		for (auto& entry : entries) {
+			if (entry.texture == texture && entry.miplevel == miplevel && entry.layer == layer) {
+				entry.last_used = use_count;
+				return entry.fbo;
+			}
+		}
+
+		if (entries.size() >= kCapacity) {
+			size_t oldest = 0;
+			for (size_t i = 1; i < entries.size(); i++) {
+				if (entries[i].last_used < entries[oldest].last_used) {
+					oldest = i;
+				}
+			}
+			RemoveAt(oldest);
+		}
+
+		Entry entry;
+		entry.texture = texture;
+		entry.miplevel = miplevel;
+		entry.layer = layer;
+		entry.last_used = use_count;
+		glGenFramebuffers(1, &entry.fbo);
+		entries.push_back(entry);
+		return entry.fbo;
+	}
+
+	/**
+	 * @brief Delete every fbo of texture.
+	 */
+	void Invalidate(GLuint texture) {
+		for (size_t i = entries.size(); i > 0; i--) {
+			if (entries[i - 1].texture == texture) {
+				RemoveAt(i - 1);
+			}
+		}
+	}
+
+	/**
+	 * @brief Called once per frame. Periodically delete fbos of textures that don't exist anymore.
+	 */
+	void Trim() {
+		if (++frames_since_trim < kTrimIntervalFrames) {
+			return;
+		}
+		frames_since_trim = 0;
+
+		for (size_t i = entries.size(); i > 0; i--) {
+			if (!glIsTexture(entries[i - 1].texture)) {
+				RemoveAt(i - 1);
+			}
+		}
+	}
+
+	/**
+	 * @brief Delete all fbos.
+	 */
+	void Clear() {
+		for (auto& entry : entries) {
+			glDeleteFramebuffers(1, &entry.fbo);
+		}
+		entries.clear();
+	}
+
+private:
+	struct Entry {
+		GLuint fbo;
+		GLuint texture;
+		int miplevel;
+		int layer;
+		uint64_t last_used;
+	};
+
+	void RemoveAt(size_t index) {
+		glDeleteFramebuffers(1, &entries[index].fbo);
+		entries[index] = entries.back();
+		entries.pop_back();
+	}
+
+	std::vector<Entry> entries;
+	uint64_t use_count = 0;
+	int frames_since_trim = 0;
+};
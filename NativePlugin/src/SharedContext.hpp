@@ -0,0 +1,129 @@
+#pragma once
+// Opengl includes
+#include <GL/glew.h>
+#if defined(_WIN32)
+	#include <GL/wglew.h>
+#elif defined(__linux__)
+	#include <GL/glxew.h>
+#endif
+
+/**
+ * @brief A gl context sharing objects with Unity's, to be made current on a thread owned by the plugin.
+ *
+ * Create() and Destroy() must be called in render thread, with Unity's context current.
+ * MakeCurrent() and Release() are called in the thread using the context.
+ * Supported with WGL on Windows and GLX on Linux, Create() fails elsewhere, e.g. when Unity uses EGL.
+ */
+class SharedContext {
+public:
+	~SharedContext() {
+		Destroy();
+	}
+
+#if defined(_WIN32)
+	bool Create() {
+		Destroy();
+		HGLRC unity_context = wglGetCurrentContext();
+		device_context = wglGetCurrentDC();
+		if (unity_context == nullptr || device_context == nullptr || !WGLEW_ARB_create_context) {
+			return false;
+		}
+		const int attribs[] = {
+			WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
+			WGL_CONTEXT_MINOR_VERSION_ARB, 2,
+			WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+			0
+		};
+		context = wglCreateContextAttribsARB(device_context, unity_context, attribs);
+		return context != nullptr;
+	}
+
+	bool MakeCurrent() {
+		return wglMakeCurrent(device_context, context) == TRUE;
+	}
+
+	void Release() {
+		wglMakeCurrent(nullptr, nullptr);
+	}
+
+	void Destroy() {
+		if (context != nullptr) {
+			wglDeleteContext(context);
+			context = nullptr;
+		}
+	}
+
+private:
+	HDC device_context = nullptr;
+	HGLRC context = nullptr;
+
+#elif defined(__linux__)
+	bool Create() {
+		Destroy();
+		GLXContext unity_context = glXGetCurrentContext();
+		display = glXGetCurrentDisplay();
+		if (unity_context == nullptr || display == nullptr || !GLXEW_ARB_create_context) {
+			return false;
+		}
+
+		// Use the config of Unity's context, sharing is only allowed between compatible ones.
+		int config_id = 0;
+		int screen = 0;
+		glXQueryContext(display, unity_context, GLX_FBCONFIG_ID, &config_id);
+		glXQueryContext(display, unity_context, GLX_SCREEN, &screen);
+		const int config_attribs[] = { GLX_FBCONFIG_ID, config_id, None };
+		int config_count = 0;
+		GLXFBConfig* configs = glXChooseFBConfig(display, screen, config_attribs, &config_count);
+		if (configs == nullptr) {
+			return false;
+		}
+		GLXFBConfig config = configs[0];
+		XFree(configs);
+
+		const int attribs[] = {
+			GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+			GLX_CONTEXT_MINOR_VERSION_ARB, 2,
+			GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+			None
+		};
+		context = glXCreateContextAttribsARB(display, config, unity_context, True, attribs);
+		if (context == nullptr) {
+			return false;
+		}
+		// Nothing is drawn, a tiny pbuffer is only there for drivers that don't allow a context without drawable.
+		const int pbuffer_attribs[] = { GLX_PBUFFER_WIDTH, 1, GLX_PBUFFER_HEIGHT, 1, None };
+		pbuffer = glXCreatePbuffer(display, config, pbuffer_attribs);
+		return true;
+	}
+
+	bool MakeCurrent() {
+		return glXMakeContextCurrent(display, pbuffer, pbuffer, context) == True;
+	}
+
+	void Release() {
+		glXMakeContextCurrent(display, None, None, nullptr);
+	}
+
+	void Destroy() {
+		if (pbuffer != 0) {
+			glXDestroyPbuffer(display, pbuffer);
+			pbuffer = 0;
+		}
+		if (context != nullptr) {
+			glXDestroyContext(display, context);
+			context = nullptr;
+		}
+	}
+
+private:
+	Display* display = nullptr;
+	GLXContext context = nullptr;
+	GLXPbuffer pbuffer = 0;
+
+#else
+	bool Create() { return false; }
+	bool MakeCurrent() { return false; }
+	void Release() {}
+	void Destroy() {}
+#endif
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Bounded lock-free queue with exactly one producer thread and one consumer thread.
+ */
+template <class T>
+class SpscQueue {
+public:
+	/**
+	 * @param capacity Max number of items in the queue, rounded up to a power of two.
+	 */
+	explicit SpscQueue(size_t capacity) :
+		head(0),
+		tail(0)
+	{
+		size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		items.resize(size);
+		mask = size - 1;
+	}
+
+	/**
+	 * @brief Called by producer.
+	 * @return false if queue is full.
+	 */
+	bool Push(const T& item) {
+		size_t current_tail = tail.load(std::memory_order_relaxed);
+		if (current_tail - head.load(std::memory_order_acquire) > mask) {
+			return false;
+		}
+		items[current_tail & mask] = item;
+		tail.store(current_tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Called by consumer.
+	 * @return false if queue is empty.
+	 */
+	bool Pop(T* item) {
+		size_t current_head = head.load(std::memory_order_relaxed);
+		if (current_head == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		*item = std::move(items[current_head & mask]);
+		items[current_head & mask] = T();
+		head.store(current_head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::vector<T> items;
+	size_t mask;
+	// Keep the indices apart, so producer and consumer don't fight over one cache line.
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+};
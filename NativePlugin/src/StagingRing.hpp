@@ -0,0 +1,157 @@
+#pragma once
+// Opengl includes
+#include <GL/glew.h>
+#include <cstddef>
+#include <deque>
+
+/**
+ * @brief One large pixel pack buffer, created with glBufferStorage and persistently mapped,
+ * sub-allocated as a ring for readback requests.
+ *
+ * Allocations are usually released in the order they were made. Out-of-order releases are remembered,
+ * and their space is reclaimed once every older allocation is released too.
+ *
+ * Only available if ARB_buffer_storage is supported. Must be used in render thread.
+ */
+class StagingRing {
+public:
+	// Offsets handed out are aligned to this, which satisfies every pixel type and copy alignment.
+	static const size_t kAlignment = 256;
+
+	static bool IsSupported() {
+		return (GLEW_ARB_buffer_storage || GLEW_VERSION_4_4) && glBufferStorage != nullptr;
+	}
+
+	/**
+	 * @brief Create and map the buffer.
+	 * @return false if extension is not supported or creation failed.
+	 */
+	bool Create(size_t size) {
+		Destroy();
+		if (size == 0 || !IsSupported()) {
+			return false;
+		}
+		const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+		glBufferStorage(GL_PIXEL_PACK_BUFFER, size, nullptr, flags);
+		mapped = static_cast<char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags));
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		if (mapped == nullptr) {
+			glDeleteBuffers(1, &buffer);
+			buffer = 0;
+			return false;
+		}
+		capacity = size;
+		return true;
+	}
+
+	/**
+	 * @brief Unmap and delete the buffer. All allocations must have been released, or gpu might still write to it.
+	 */
+	void Destroy() {
+		if (buffer != 0) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			glDeleteBuffers(1, &buffer);
+		}
+		buffer = 0;
+		mapped = nullptr;
+		capacity = 0;
+		head = 0;
+		used = 0;
+		allocations.clear();
+	}
+
+	/**
+	 * @brief Reserve size bytes in the ring.
+	 * @param offset Receives offset of the reserved range in the buffer.
+	 * @return false if there's no enough continuous free space.
+	 */
+	bool Allocate(size_t size, size_t* offset) {
+		if (buffer == 0 || size == 0) {
+			return false;
+		}
+		size = (size + kAlignment - 1) / kAlignment * kAlignment;
+		size_t tail = allocations.empty() ? head : allocations.front().begin;
+		size_t begin = head;
+		size_t consumed = 0;
+		if (used == 0) {
+			// Empty ring, restart from the beginning to get the largest continuous range.
+			head = begin = 0;
+			if (size > capacity)
+				return false;
+			*offset = 0;
+			consumed = size;
+		}
+		else if (head > tail) {
+			// Free space is [head, capacity) and [0, tail)
+			if (capacity - head >= size) {
+				*offset = head;
+				consumed = size;
+			}
+			else if (tail >= size) {
+				// Wrap around, the unused end of buffer is accounted to this allocation.
+				*offset = 0;
+				consumed = capacity - head + size;
+			}
+			else {
+				return false;
+			}
+		}
+		else {
+			// Free space is [head, tail)
+			if (tail - head < size)
+				return false;
+			*offset = head;
+			consumed = size;
+		}
+
+		Allocation allocation;
+		allocation.begin = begin;
+		allocation.offset = *offset;
+		allocation.consumed = consumed;
+		allocation.released = false;
+		allocations.push_back(allocation);
+		used += consumed;
+		head = (*offset + size) % capacity;
+		return true;
+	}
+
+	/**
+	 * @brief Release a range returned by Allocate. Gpu must have finished writing to it.
+	 */
+	void Release(size_t offset) {
+		for (auto& allocation : allocations) {
+			if (allocation.offset == offset && !allocation.released) {
+				allocation.released = true;
+				break;
+			}
+		}
+		while (!allocations.empty() && allocations.front().released) {
+			used -= allocations.front().consumed;
+			allocations.pop_front();
+		}
+	}
+
+	bool Empty() const { return allocations.empty(); }
+	size_t Capacity() const { return capacity; }
+	GLuint Buffer() const { return buffer; }
+	char* Data() const { return mapped; }
+
+private:
+	struct Allocation {
+		size_t begin;
+		size_t offset;
+		size_t consumed;
+		bool released;
+	};
+
+	GLuint buffer = 0;
+	char* mapped = nullptr;
+	size_t capacity = 0;
+	size_t head = 0;
+	size_t used = 0;
+	std::deque<Allocation> allocations;
+};
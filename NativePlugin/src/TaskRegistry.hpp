@@ -0,0 +1,165 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief State of a task, as seen from outside. Pending and Running are owned by render thread, the others by main thread.
+ */
+enum TaskState : uint8_t {
+	kTaskStateInvalid = 0,	//Unknown, stale or disposed handle.
+	kTaskStatePending = 1,	//Created, waiting for render thread to start it.
+	kTaskStateRunning = 2,	//Started, waiting for gpu.
+	kTaskStateDone = 3,
+	kTaskStateError = 4,
+	kTaskStateDropped = 5,	//Superseded by a newer result of the same source, has no data.
+	kTaskStateOverBudget = 6,	//Rejected as the staging memory budget is used up, has no data.
+};
+
+/**
+ * @brief Done, or ended without data. Every state after Error means no data too.
+ */
+inline bool IsFinishedState(TaskState state) {
+	return state >= kTaskStateDone;
+}
+
+/**
+ * @brief Fixed-capacity slot map of tasks, addressed by handles made of slot index and generation.
+ *
+ * Every slot has one atomic word holding its current handle and state, so status queries are lock-free,
+ * and stale or unknown handles never match. The words are kept in one contiguous array,
+ * which is shared with C# side to read states without calling into native code.
+ *
+ * Insert could be called from main thread and render thread, only the free list is locked. Remove is main thread only.
+ * The task object stored in a slot is only touched by main thread once its handle is known there,
+ * other threads keep their own references and just move the state forward.
+ */
+template <class T>
+class TaskRegistry {
+public:
+	static const int kIndexBits = 12;
+	static const uint32_t kCapacity = 1u << kIndexBits;
+	static const uint32_t kIndexMask = kCapacity - 1;
+	// Handles stay positive and non-zero, so they fit in a C# int and 0 means invalid.
+	static const uint32_t kMaxGeneration = (1u << (31 - kIndexBits)) - 1;
+
+	TaskRegistry() :
+		slots(kCapacity),
+		words(kCapacity)
+	{
+		free_indices.reserve(kCapacity);
+		for (uint32_t i = kCapacity; i > 0; i--) {
+			free_indices.push_back(i - 1);
+		}
+	}
+
+	/**
+	 * @brief Put task in a free slot as Pending.
+	 * @return Handle of the task, 0 if registry is full.
+	 */
+	int Insert(std::shared_ptr<T> task) {
+		uint32_t index = 0;
+		{
+			std::lock_guard<std::mutex> lock(free_mutex);
+			if (free_indices.empty()) {
+				return 0;
+			}
+			index = free_indices.back();
+			free_indices.pop_back();
+		}
+
+		Slot& slot = slots[index];
+		slot.generation = slot.generation >= kMaxGeneration ? 1 : slot.generation + 1;
+		int handle = (int)((slot.generation << kIndexBits) | index);
+		slot.task = task;
+		words[index].store(Pack(handle, kTaskStatePending), std::memory_order_release);
+		return handle;
+	}
+
+	/**
+	 * @brief Free the slot of a finished task. Main thread only, which owns finished tasks.
+	 */
+	bool Remove(int handle) {
+		if (!IsFinishedState(GetState(handle))) {
+			return false;
+		}
+		words[handle & kIndexMask].store(0, std::memory_order_release);
+		slots[handle & kIndexMask].task.reset();
+		std::lock_guard<std::mutex> lock(free_mutex);
+		free_indices.push_back(handle & kIndexMask);
+		return true;
+	}
+
+	/**
+	 * @brief Lock-free status query, could be called from any thread.
+	 */
+	TaskState GetState(int handle) const {
+		if (handle <= 0) {
+			return kTaskStateInvalid;
+		}
+		uint64_t word = words[handle & kIndexMask].load(std::memory_order_acquire);
+		if ((int)(word >> 32) != handle) {
+			return kTaskStateInvalid;
+		}
+		return (TaskState)(word & 0xff);
+	}
+
+	/**
+	 * @brief Move task to another state, if handle is still current. Called by the thread owning the current state.
+	 */
+	bool SetState(int handle, TaskState from, TaskState to) {
+		if (handle <= 0) {
+			return false;
+		}
+		uint64_t expected = Pack(handle, from);
+		return words[handle & kIndexMask].compare_exchange_strong(expected, Pack(handle, to), std::memory_order_acq_rel);
+	}
+
+	/**
+	 * @brief Get the task of handle if it's in the given state. Main thread only.
+	 */
+	std::shared_ptr<T> Get(int handle, TaskState state) const {
+		if (GetState(handle) != state) {
+			return nullptr;
+		}
+		return slots[handle & kIndexMask].task;
+	}
+
+	/**
+	 * @brief Get the task of handle in whatever state it's in, nullptr if handle isn't alive. Main thread only.
+	 * Other threads might be moving its state meanwhile, but only main thread frees the slot.
+	 */
+	std::shared_ptr<T> GetAlive(int handle) const {
+		if (GetState(handle) == kTaskStateInvalid) {
+			return nullptr;
+		}
+		return slots[handle & kIndexMask].task;
+	}
+
+	/**
+	 * @brief The state words of all slots, indexed by (handle & kIndexMask).
+	 * A word is (handle << 32 | state), and is 0 for free slots. Valid for the lifetime of registry.
+	 */
+	const std::atomic<uint64_t>* StateWords() const {
+		return words.data();
+	}
+
+private:
+	struct Slot {
+		std::shared_ptr<T> task;
+		uint32_t generation;	//Only touched by the thread holding the slot out of free list.
+
+		Slot() : generation(0) {}
+	};
+
+	static uint64_t Pack(int handle, TaskState state) {
+		return ((uint64_t)(uint32_t)handle << 32) | (uint64_t)state;
+	}
+
+	std::vector<Slot> slots;
+	std::vector<std::atomic<uint64_t>> words;
+	std::mutex free_mutex;
+	std::vector<uint32_t> free_indices;	//Guarded by free_mutex.
+};
@@ -0,0 +1,88 @@
+#pragma once
+// Opengl includes
+#include <GL/glew.h>
+#include <cstdint>
+#include <unordered_map>
+
+/**
+ * @brief What a readback needs to know about a level of texture.
+ */
+struct TextureLevelInfo {
+	GLenum target;
+	GLint width;
+	GLint height;
+	GLint depth;	//Slices of 3D texture, layers of array, or faces of cubemap (array).
+	GLint internal_format;
+};
+
+/**
+ * @brief Remembers TextureLevelInfo of texture levels, so they're only queried from driver once.
+ *
+ * The info of a texture is dropped by Invalidate() when it's destroyed or reinitialized,
+ * and textures deleted behind our back are found by Trim() periodically.
+ * A name reused by a new texture can't be told apart here, users check size and format of what they find.
+ *
+ * Must be used in render thread.
+ */
+class TextureInfoCache {
+public:
+	// Look for deleted textures once every this many frames.
+	static const int kTrimIntervalFrames = 120;
+
+	/**
+	 * @return false if the level is not cached.
+	 */
+	bool Find(GLuint texture, int miplevel, TextureLevelInfo* info) const {
+		auto it = levels.find(KeyOf(texture, miplevel));
+		if (it == levels.end()) {
+			return false;
+		}
+		*info = it->second;
+		return true;
+	}
+
+	void Add(GLuint texture, int miplevel, const TextureLevelInfo& info) {
+		levels[KeyOf(texture, miplevel)] = info;
+	}
+
+	/**
+	 * @brief Forget every level of texture.
+	 */
+	void Invalidate(GLuint texture) {
+		for (auto it = levels.begin(); it != levels.end();) {
+			if ((GLuint)(it->first >> 32) == texture)
+				it = levels.erase(it);
+			else
+				++it;
+		}
+	}
+
+	/**
+	 * @brief Called once per frame. Periodically forget textures that don't exist anymore.
+	 */
+	void Trim() {
+		if (++frames_since_trim < kTrimIntervalFrames) {
+			return;
+		}
+		frames_since_trim = 0;
+
+		for (auto it = levels.begin(); it != levels.end();) {
+			if (!glIsTexture((GLuint)(it->first >> 32)))
+				it = levels.erase(it);
+			else
+				++it;
+		}
+	}
+
+	void Clear() {
+		levels.clear();
+	}
+
+private:
+	static uint64_t KeyOf(GLuint texture, int miplevel) {
+		return ((uint64_t)texture << 32) | (uint32_t)miplevel;
+	}
+
+	std::unordered_map<uint64_t, TextureLevelInfo> levels;
+	int frames_since_trim = 0;
+};
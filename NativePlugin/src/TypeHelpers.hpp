@@ -159,6 +159,14 @@ inline int getFormatFromInternalFormat(int internalFormat)
 
 		case GL_SRGB8:
 			return GL_RGB;
+
+		case GL_DEPTH_COMPONENT16:
+		case GL_DEPTH_COMPONENT32:
+		case GL_DEPTH_COMPONENT32F:
+			return GL_DEPTH_COMPONENT;
+
+		case GL_DEPTH24_STENCIL8:
+			return GL_DEPTH_STENCIL;
 	}
 	return 0;
 }
@@ -237,6 +245,18 @@ inline int getTypeFromInternalFormat(int internalFormat)
 		case GL_RGB32I:
 		case GL_RGBA32I:
 			return GL_INT;
+
+		case GL_DEPTH_COMPONENT16:
+			return GL_UNSIGNED_SHORT;
+
+		case GL_DEPTH_COMPONENT32:
+			return GL_UNSIGNED_INT;
+
+		case GL_DEPTH_COMPONENT32F:
+			return GL_FLOAT;
+
+		case GL_DEPTH24_STENCIL8:
+			return GL_UNSIGNED_INT_24_8;
 	}
 	return 0;
 }
\ No newline at end of file
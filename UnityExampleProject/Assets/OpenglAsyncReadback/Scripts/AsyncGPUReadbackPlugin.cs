@@ -7,6 +7,9 @@ using UnityEngine.Rendering;
 using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
 using System.Collections.Generic;
+#if UNITY_2019_1_OR_NEWER
+using UnityEngine.Experimental.Rendering;
+#endif
 
 namespace Yangrc.OpenGLAsyncReadback {
     /// <summary>
@@ -37,17 +40,30 @@ namespace Yangrc.OpenGLAsyncReadback {
             }
         }
 
+        static List<Texture> deadTextures = new List<Texture>();
+        static List<ComputeBuffer> deadBuffers = new List<ComputeBuffer>();
+
         static public void ClearDeadRefs() {    //Clear disposed pointers.
             foreach (var item in cbPtrs) {
                 if (item.Key == null)
-                    cbPtrs.Remove(item.Key);
+                    deadBuffers.Add(item.Key);
+            }
+            foreach (var item in deadBuffers) {
+                cbPtrs.Remove(item);
             }
+            deadBuffers.Clear();
 
             foreach (var item in ptrs) {
                 if (item.Key == null) {
-                    ptrs.Remove(item.Key);
+                    deadTextures.Add(item.Key);
                 }
             }
+            foreach (var item in deadTextures) {
+                //Native plugin may have cached objects for it.
+                OpenGLAsyncReadbackSettings.InvalidateTexture(ptrs[item].ToInt32());
+                ptrs.Remove(item);
+            }
+            deadTextures.Clear();
         }
     }
 
@@ -64,6 +80,348 @@ namespace Yangrc.OpenGLAsyncReadback {
         }
     }
 
+    /// <summary>
+    /// Target, size and internal format of a texture level. Layout must match TextureLevelInfo in native code.
+    /// Passing it with a request saves the render thread from querying the driver.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct OpenGLTextureLevelInfo {
+        public uint target;
+        public int width;
+        public int height;
+        public int depth;
+        public int internalFormat;
+
+        /// <summary>
+        /// Fill info of a level from what Unity knows about the texture.
+        /// </summary>
+        /// <returns>false if the format or dimension has no known OpenGL equivalent, then let the plugin query it instead.</returns>
+        public static bool TryGetFor(Texture tex, int mipmapIndex, out OpenGLTextureLevelInfo info) {
+            info = new OpenGLTextureLevelInfo();
+#if UNITY_2019_1_OR_NEWER
+            int layers = 1;
+            switch (tex.dimension) {
+                case TextureDimension.Tex2D:
+                    info.target = 0x0DE1;   //GL_TEXTURE_2D
+                    break;
+                case TextureDimension.Tex3D:
+                    info.target = 0x806F;   //GL_TEXTURE_3D
+                    layers = tex is RenderTexture ? ((RenderTexture)tex).volumeDepth : ((Texture3D)tex).depth;
+                    layers = Mathf.Max(1, layers >> mipmapIndex);
+                    break;
+                case TextureDimension.Tex2DArray:
+                    info.target = 0x8C1A;   //GL_TEXTURE_2D_ARRAY
+                    layers = tex is RenderTexture ? ((RenderTexture)tex).volumeDepth : ((Texture2DArray)tex).depth;
+                    break;
+                case TextureDimension.Cube:
+                    info.target = 0x8513;   //GL_TEXTURE_CUBE_MAP
+                    layers = 6;
+                    break;
+                case TextureDimension.CubeArray:
+                    info.target = 0x9009;   //GL_TEXTURE_CUBE_MAP_ARRAY
+                    layers = tex is RenderTexture ? ((RenderTexture)tex).volumeDepth : ((CubemapArray)tex).cubemapCount * 6;
+                    break;
+                default:
+                    return false;
+            }
+
+            switch (tex.graphicsFormat) {
+                case GraphicsFormat.R8_UNorm: info.internalFormat = 0x8229; break;  //GL_R8
+                case GraphicsFormat.R8G8_UNorm: info.internalFormat = 0x822B; break;    //GL_RG8
+                case GraphicsFormat.R8G8B8A8_UNorm: info.internalFormat = 0x8058; break;    //GL_RGBA8
+                case GraphicsFormat.R8G8B8A8_SRGB: info.internalFormat = 0x8C43; break; //GL_SRGB8_ALPHA8
+                case GraphicsFormat.R16_UNorm: info.internalFormat = 0x822A; break; //GL_R16
+                case GraphicsFormat.R16G16B16A16_UNorm: info.internalFormat = 0x805B; break;    //GL_RGBA16
+                case GraphicsFormat.R16_SFloat: info.internalFormat = 0x822D; break;    //GL_R16F
+                case GraphicsFormat.R16G16_SFloat: info.internalFormat = 0x822F; break; //GL_RG16F
+                case GraphicsFormat.R16G16B16A16_SFloat: info.internalFormat = 0x881A; break;   //GL_RGBA16F
+                case GraphicsFormat.R32_SFloat: info.internalFormat = 0x822E; break;    //GL_R32F
+                case GraphicsFormat.R32G32_SFloat: info.internalFormat = 0x8230; break; //GL_RG32F
+                case GraphicsFormat.R32G32B32A32_SFloat: info.internalFormat = 0x8814; break;   //GL_RGBA32F
+                case GraphicsFormat.R32_UInt: info.internalFormat = 0x8236; break;  //GL_R32UI
+                case GraphicsFormat.R32_SInt: info.internalFormat = 0x8235; break;  //GL_R32I
+                case GraphicsFormat.B10G11R11_UFloatPack32: info.internalFormat = 0x8C3A; break;    //GL_R11F_G11F_B10F
+                case GraphicsFormat.A2B10G10R10_UNormPack32: info.internalFormat = 0x8059; break;   //GL_RGB10_A2
+                default:
+                    return false;
+            }
+
+            info.width = Mathf.Max(1, tex.width >> mipmapIndex);
+            info.height = Mathf.Max(1, tex.height >> mipmapIndex);
+            info.depth = layers;
+            return true;
+#else
+            return false;
+#endif
+        }
+    }
+
+    /// <summary>
+    /// One request of a batch, see OpenGLAsyncReadbackRequest.CreateBatchRequest. Layout must match ReadbackRequestDesc in native code.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct OpenGLReadbackRequestDesc {
+        public int kind;
+        public uint glObject;
+        public int mipLevel;
+        public int x, y, z;
+        public int width, height, depth;
+        public long offset, size;
+
+        /// <summary>
+        /// Read a region of a texture level, a size of 0 means up to the end of level.
+        /// </summary>
+        public static OpenGLReadbackRequestDesc ForTexture(Texture tex, int mipmapIndex = 0, int x = 0, int width = 0, int y = 0, int height = 0, int z = 0, int depth = 0) {
+            return new OpenGLReadbackRequestDesc() {
+                kind = 0,
+                glObject = (uint)RenderTextureRegistery.GetFor(tex).ToInt32(),
+                mipLevel = mipmapIndex,
+                x = x, y = y, z = z,
+                width = width, height = height, depth = depth,
+            };
+        }
+
+        public static OpenGLReadbackRequestDesc ForComputeBuffer(ComputeBuffer computeBuffer) {
+            return new OpenGLReadbackRequestDesc() {
+                kind = 1,
+                glObject = (uint)computeBuffer.GetNativeBufferPtr().ToInt32(),
+                size = (long)computeBuffer.stride * computeBuffer.count,
+            };
+        }
+    }
+
+    /// <summary>
+    /// Parameters of a request made in render thread, see OpenGLReadbackEvent. Layout must match ReadbackEventData in native code.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct OpenGLReadbackEventData {
+        public OpenGLReadbackRequestDesc request;
+        public IntPtr destination;
+        public ulong destinationCapacity;
+        public int eventId;
+    }
+
+    /// <summary>
+    /// A request issued by a render event, so it could be recorded into a CommandBuffer and read at that exact point of the frame.
+    /// A new request is made each time the event runs, lastRequest is the latest one.
+    /// Parameters live in native memory, which must outlive every CommandBuffer the event is issued to.
+    /// </summary>
+    public class OpenGLReadbackEvent : IDisposable {
+        private IntPtr data;
+        private bool intoDestination;
+
+        public static OpenGLReadbackEvent Create(OpenGLReadbackRequestDesc desc) {
+            return CreateInto(desc, IntPtr.Zero, 0);
+        }
+
+        /// <summary>
+        /// Result is written into destination, which must stay valid as long as the event could run.
+        /// </summary>
+        public static OpenGLReadbackEvent CreateInto(OpenGLReadbackRequestDesc desc, IntPtr destination, long capacity) {
+            var result = new OpenGLReadbackEvent();
+            result.data = Marshal.AllocHGlobal(Marshal.SizeOf(typeof(OpenGLReadbackEventData)));
+            result.intoDestination = destination != IntPtr.Zero;
+            Marshal.StructureToPtr(new OpenGLReadbackEventData() {
+                request = desc,
+                destination = destination,
+                destinationCapacity = (ulong)capacity,
+            }, result.data, false);
+            return result;
+        }
+
+        public static OpenGLReadbackEvent Create(Texture tex, int mipmapIndex = 0) {
+            return Create(OpenGLReadbackRequestDesc.ForTexture(tex, mipmapIndex));
+        }
+
+        public static OpenGLReadbackEvent Create(ComputeBuffer computeBuffer) {
+            return Create(OpenGLReadbackRequestDesc.ForComputeBuffer(computeBuffer));
+        }
+
+        /// <summary>
+        /// Record the request into cmd. It's made every time cmd is executed.
+        /// </summary>
+        public void IssueTo(CommandBuffer cmd) {
+            cmd.IssuePluginEventAndData(GetRequestInRenderThreadFunctionPtr(), 0, data);
+        }
+
+        /// <summary>
+        /// Make the request once, at the current point of render thread's command stream.
+        /// </summary>
+        public void Issue() {
+            using (var cmd = new CommandBuffer()) {
+                IssueTo(cmd);
+                Graphics.ExecuteCommandBuffer(cmd);
+            }
+        }
+
+        /// <summary>
+        /// Request made by the latest run of event. Invalid until it has run once.
+        /// </summary>
+        public UniversalAsyncGPUReadbackRequest lastRequest {
+            get {
+                int handle = Marshal.ReadInt32(data, (int)Marshal.OffsetOf(typeof(OpenGLReadbackEventData), "eventId"));
+                return UniversalAsyncGPUReadbackRequest.OpenGLFromHandle(handle, intoDestination);
+            }
+        }
+
+        /// <summary>
+        /// Free the parameters. Only call it once no CommandBuffer could run the event anymore.
+        /// </summary>
+        public void Dispose() {
+            if (data != IntPtr.Zero) {
+                Marshal.FreeHGlobal(data);
+                data = IntPtr.Zero;
+            }
+        }
+
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern IntPtr GetRequestInRenderThreadFunctionPtr();
+    }
+
+    /// <summary>
+    /// Statistics of native pixel buffer pool. Layout must match PboPoolStats in native code.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct PboPoolStats {
+        public ulong hits;
+        public ulong misses;
+        public ulong allocatedBytes;
+        public ulong idleBytes;
+    }
+
+    /// <summary>
+    /// Profiling counters of the native plugin. Only meaningful under OpenGL.
+    /// </summary>
+    public static class OpenGLAsyncReadbackStats {
+        public static PboPoolStats GetPboPoolStats() {
+            var stats = new PboPoolStats();
+            if (OpenGLAsyncReadbackRequest.IsAvailable()) {
+                GetPboPoolStats(ref stats);
+            }
+            return stats;
+        }
+
+        /// <summary>
+        /// Number of requests of a latest-frame-only texture dropped, see OpenGLAsyncReadbackSettings.SetLatestFrameOnly.
+        /// </summary>
+        public static long GetDroppedFrameCount(Texture tex) {
+            if (!OpenGLAsyncReadbackRequest.IsAvailable()) {
+                return 0;
+            }
+            return (long)GetDroppedFrameCount((uint)RenderTextureRegistery.GetFor(tex).ToInt32());
+        }
+
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void GetPboPoolStats(ref PboPoolStats stats);
+        /// <summary>
+        /// Staging memory held by running requests and results not consumed yet. Throttle requests when it's near the budget.
+        /// </summary>
+        public static long GetInFlightBytes() {
+            if (!OpenGLAsyncReadbackRequest.IsAvailable()) {
+                return 0;
+            }
+            return (long)GetInFlightBytesNative();
+        }
+
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern ulong GetDroppedFrameCount(uint texture);
+        [DllImport("AsyncGPUReadbackPlugin", EntryPoint = "GetInFlightBytes")]
+        private static extern ulong GetInFlightBytesNative();
+    }
+
+    /// <summary>
+    /// Tunables of the native plugin. Only meaningful under OpenGL.
+    /// </summary>
+    public static class OpenGLAsyncReadbackSettings {
+        /// <summary>
+        /// Size of the persistent mapped staging ring used when ARB_buffer_storage is available. 0 to disable it.
+        /// Requests that don't fit in the ring fall back to standalone pixel buffers.
+        /// </summary>
+        public static void SetStagingRingSize(long bytes) {
+            if (OpenGLAsyncReadbackRequest.IsAvailable()) {
+                SetStagingRingSize((ulong)bytes);
+            }
+        }
+
+        /// <summary>
+        /// Tell native plugin a texture is destroyed or reinitialized, so everything it cached for the texture is dropped right away.
+        /// Must be called if a texture changes size or format but keeps its native texture, e.g. after Texture2D.Reinitialize.
+        /// Destroyed textures requested through UniversalAsyncGPUReadbackRequest are handled automatically.
+        /// </summary>
+        public static void InvalidateTexture(int textureOpenGLName) {
+            if (OpenGLAsyncReadbackRequest.IsAvailable()) {
+                InvalidateTexture((uint)textureOpenGLName);
+            }
+        }
+
+        /// <summary>
+        /// Only keep the latest result of a texture, for real-time consumers.
+        /// When a newer request of it is done, older ones still in flight are dropped,
+        /// and older results not read yet are disposed right away. Dropped requests are done with error.
+        /// </summary>
+        public static void SetLatestFrameOnly(Texture tex, bool enabled) {
+            if (OpenGLAsyncReadbackRequest.IsAvailable()) {
+                SetLatestFrameOnly((uint)RenderTextureRegistery.GetFor(tex).ToInt32(), enabled);
+            }
+        }
+
+        /// <summary>
+        /// Limit memory held by running requests and results not consumed yet, 0 for unlimited (default).
+        /// Requests over budget are done with error, and their overBudget is true.
+        /// </summary>
+        public static void SetInFlightByteBudget(long bytes) {
+            if (OpenGLAsyncReadbackRequest.IsAvailable()) {
+                SetInFlightByteBudget((ulong)bytes);
+            }
+        }
+
+        /// <summary>
+        /// Transfers larger than this are split into chunks, each one available as soon as it lands. Clamped to [1MB, 1GB], 128MB by default.
+        /// </summary>
+        public static void SetTransferChunkSize(long bytes) {
+            if (OpenGLAsyncReadbackRequest.IsAvailable()) {
+                SetTransferChunkSize((ulong)bytes);
+            }
+        }
+
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void SetStagingRingSize(ulong size);
+        /// <summary>
+        /// Limit bytes copied out of gpu per frame, 0 for unlimited, which is the default.
+        /// Requests over it stay pending until a later frame, and larger readbacks are split into tiles spread across frames,
+        /// so their source must stay unchanged until they're done.
+        /// </summary>
+        public static void SetFrameTransferBudget(long bytes) {
+            if (OpenGLAsyncReadbackRequest.IsAvailable()) {
+                SetFrameTransferBudget((ulong)bytes);
+            }
+        }
+
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void SetTransferChunkSize(ulong size);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void SetFrameTransferBudget(ulong bytes);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void SetInFlightByteBudget(ulong bytes);
+        /// <summary>
+        /// Wait for the gpu in a thread of the plugin, with a context shared with Unity's, so requests are done as soon as
+        /// the gpu finishes them instead of on next frame. Off by default, and stays off if a shared context can't be created.
+        /// Requests into a pool buffer, in latest-frame-only mode or transferred in chunks are still finished on render thread.
+        /// </summary>
+        public static void SetReadbackThread(bool enabled) {
+            if (OpenGLAsyncReadbackRequest.IsAvailable()) {
+                SetReadbackThreadNative(enabled);
+            }
+        }
+
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void SetLatestFrameOnly(uint texture, [MarshalAs(UnmanagedType.I1)] bool enabled);
+        [DllImport("AsyncGPUReadbackPlugin", EntryPoint = "SetReadbackThread")]
+        private static extern void SetReadbackThreadNative([MarshalAs(UnmanagedType.I1)] bool enabled);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void InvalidateTexture(uint texture);
+    }
+
     /// <summary>
     /// Helper struct that wraps unity async readback and our opengl readback together, to hide difference
     /// </summary>
@@ -84,6 +442,13 @@ namespace Yangrc.OpenGLAsyncReadback {
                     uRequest = AsyncGPUReadback.Request(src, mipIndex: mipmapIndex),
                 };
             } else {
+                OpenGLTextureLevelInfo info;
+                if (OpenGLTextureLevelInfo.TryGetFor(src, mipmapIndex, out info)) {
+                    return new UniversalAsyncGPUReadbackRequest() {
+                        isPlugin = true,
+                        oRequest = OpenGLAsyncReadbackRequest.CreateTextureRegionRequest(RenderTextureRegistery.GetFor(src).ToInt32(), mipmapIndex, 0, 0, 0, 0, 0, 0, info)
+                    };
+                }
                 return new UniversalAsyncGPUReadbackRequest() {
                     isPlugin = true,
                     oRequest = OpenGLAsyncReadbackRequest.CreateTextureRequest(RenderTextureRegistery.GetFor(src).ToInt32(), mipmapIndex)
@@ -91,6 +456,58 @@ namespace Yangrc.OpenGLAsyncReadback {
             }
         }
 
+        /// <summary>
+        /// Request readback of several textures at once, e.g. views of many cameras.
+        /// Under OpenGL, they're made with one call into plugin, started with one render event, and share one fence.
+        /// </summary>
+        public static UniversalAsyncGPUReadbackRequest[] RequestBatch(Texture[] srcs, int mipmapIndex = 0) {
+            var results = new UniversalAsyncGPUReadbackRequest[srcs.Length];
+            if (SystemInfo.supportsAsyncGPUReadback) {
+                for (int i = 0; i < srcs.Length; i++) {
+                    results[i] = Request(srcs[i], mipmapIndex);
+                }
+                return results;
+            }
+            var descs = new OpenGLReadbackRequestDesc[srcs.Length];
+            for (int i = 0; i < srcs.Length; i++) {
+                descs[i] = OpenGLReadbackRequestDesc.ForTexture(srcs[i], mipmapIndex);
+            }
+            var requests = OpenGLAsyncReadbackRequest.CreateBatchRequest(descs);
+            for (int i = 0; i < srcs.Length; i++) {
+                results[i] = new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = true,
+                    oRequest = requests[i],
+                };
+            }
+            return results;
+        }
+
+        /// <summary>
+        /// Request readback of a region of a texture. Same parameters as Unity's AsyncGPUReadback.Request.
+        /// </summary>
+        public static UniversalAsyncGPUReadbackRequest Request(Texture src, int mipIndex, int x, int width, int y, int height, int z, int depth) {
+            if (SystemInfo.supportsAsyncGPUReadback) {
+                return new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = false,
+                    uInited = true,
+                    uDisposd = false,
+                    uRequest = AsyncGPUReadback.Request(src, mipIndex, x, width, y, height, z, depth),
+                };
+            } else {
+                OpenGLTextureLevelInfo info;
+                if (OpenGLTextureLevelInfo.TryGetFor(src, mipIndex, out info)) {
+                    return new UniversalAsyncGPUReadbackRequest() {
+                        isPlugin = true,
+                        oRequest = OpenGLAsyncReadbackRequest.CreateTextureRegionRequest(RenderTextureRegistery.GetFor(src).ToInt32(), mipIndex, x, y, z, width, height, depth, info)
+                    };
+                }
+                return new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = true,
+                    oRequest = OpenGLAsyncReadbackRequest.CreateTextureRegionRequest(RenderTextureRegistery.GetFor(src).ToInt32(), mipIndex, x, y, z, width, height, depth)
+                };
+            }
+        }
+
         public static UniversalAsyncGPUReadbackRequest Request(ComputeBuffer computeBuffer) {
             if (SystemInfo.supportsAsyncGPUReadback) {
                 return new UniversalAsyncGPUReadbackRequest() {
@@ -102,7 +519,78 @@ namespace Yangrc.OpenGLAsyncReadback {
             } else {
                 return new UniversalAsyncGPUReadbackRequest() {
                     isPlugin = true,
-                    oRequest = OpenGLAsyncReadbackRequest.CreateComputeBufferRequest((int)computeBuffer.GetNativeBufferPtr(), computeBuffer.stride * computeBuffer.count),
+                    oRequest = OpenGLAsyncReadbackRequest.CreateComputeBufferRequest((int)computeBuffer.GetNativeBufferPtr(), (long)computeBuffer.stride * computeBuffer.count),
+                };
+            }
+        }
+
+        /// <summary>
+        /// Request readback of a texture directly into an existing array, so no memory is allocated per request.
+        /// The array must stay alive until the request is done. Once done, output contains the data.
+        /// Before Unity 2020.1, non-OpenGL platforms can't write into existing array, use GetData() there.
+        /// </summary>
+        public static unsafe UniversalAsyncGPUReadbackRequest RequestIntoNativeArray<T>(ref NativeArray<T> output, Texture src, int mipmapIndex = 0) where T : struct {
+            if (SystemInfo.supportsAsyncGPUReadback) {
+                return new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = false,
+                    uInited = true,
+                    uDisposd = false,
+#if UNITY_2020_1_OR_NEWER
+                    uRequest = AsyncGPUReadback.RequestIntoNativeArray(ref output, src, mipmapIndex),
+#else
+                    uRequest = AsyncGPUReadback.Request(src, mipIndex: mipmapIndex),
+#endif
+                };
+            } else {
+                return new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = true,
+                    oRequest = OpenGLAsyncReadbackRequest.CreateTextureRequestInto(RenderTextureRegistery.GetFor(src).ToInt32(), mipmapIndex,
+                        NativeArrayUnsafeUtility.GetUnsafePtr(output), (long)output.Length * UnsafeUtility.SizeOf<T>())
+                };
+            }
+        }
+
+        /// <summary>
+        /// Request readback of a compute buffer directly into an existing array, so no memory is allocated per request.
+        /// The array must stay alive until the request is done. Once done, output contains the data.
+        /// Before Unity 2020.1, non-OpenGL platforms can't write into existing array, use GetData() there.
+        /// </summary>
+        public static unsafe UniversalAsyncGPUReadbackRequest RequestIntoNativeArray<T>(ref NativeArray<T> output, ComputeBuffer computeBuffer) where T : struct {
+            if (SystemInfo.supportsAsyncGPUReadback) {
+                return new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = false,
+                    uInited = true,
+                    uDisposd = false,
+#if UNITY_2020_1_OR_NEWER
+                    uRequest = AsyncGPUReadback.RequestIntoNativeArray(ref output, computeBuffer),
+#else
+                    uRequest = AsyncGPUReadback.Request(computeBuffer),
+#endif
+                };
+            } else {
+                return new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = true,
+                    oRequest = OpenGLAsyncReadbackRequest.CreateComputeBufferRequestInto((int)computeBuffer.GetNativeBufferPtr(), (long)computeBuffer.stride * computeBuffer.count,
+                        NativeArrayUnsafeUtility.GetUnsafePtr(output), (long)output.Length * UnsafeUtility.SizeOf<T>()),
+                };
+            }
+        }
+
+        /// <summary>
+        /// Request readback of size bytes starting at offset of a compute buffer. Same parameters as Unity's AsyncGPUReadback.Request.
+        /// </summary>
+        public static UniversalAsyncGPUReadbackRequest Request(ComputeBuffer computeBuffer, int size, int offset) {
+            if (SystemInfo.supportsAsyncGPUReadback) {
+                return new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = false,
+                    uInited = true,
+                    uDisposd = false,
+                    uRequest = AsyncGPUReadback.Request(computeBuffer, size, offset),
+                };
+            } else {
+                return new UniversalAsyncGPUReadbackRequest() {
+                    isPlugin = true,
+                    oRequest = OpenGLAsyncReadbackRequest.CreateComputeBufferRangeRequest((int)computeBuffer.GetNativeBufferPtr(), offset, size),
                 };
             }
         }
@@ -114,13 +602,23 @@ namespace Yangrc.OpenGLAsyncReadback {
             };
         }
 
-        public static UniversalAsyncGPUReadbackRequest OpenGLRequestComputeBuffer(int computeBuffer, int size) {
+        public static UniversalAsyncGPUReadbackRequest OpenGLRequestComputeBuffer(int computeBuffer, long size) {
             return new UniversalAsyncGPUReadbackRequest() {
                 isPlugin = true,
                 oRequest = OpenGLAsyncReadbackRequest.CreateComputeBufferRequest((int)computeBuffer, size)
             };
         }
 
+        /// <summary>
+        /// Wrap a request made in render thread, e.g. by OpenGLReadbackEvent.
+        /// </summary>
+        internal static UniversalAsyncGPUReadbackRequest OpenGLFromHandle(int handle, bool intoDestination) {
+            return new UniversalAsyncGPUReadbackRequest() {
+                isPlugin = true,
+                oRequest = OpenGLAsyncReadbackRequest.FromHandle(handle, intoDestination)
+            };
+        }
+
         [Obsolete]
         public void Update() {
             //if (isPlugin) {
@@ -150,6 +648,15 @@ namespace Yangrc.OpenGLAsyncReadback {
             }
         }
 
+        /// <summary>
+        /// Under OpenGL, true if the request is rejected by OpenGLAsyncReadbackSettings.SetInFlightByteBudget. hasError is true too then.
+        /// </summary>
+        public bool overBudget {
+            get {
+                return isPlugin && oRequest.overBudget;
+            }
+        }
+
         /// <summary>
         /// Get data of a readback request.  
         /// The data is allocated as temp, so it only stay alive for one frame.
@@ -164,6 +671,44 @@ namespace Yangrc.OpenGLAsyncReadback {
             }
         }
 
+        /// <summary>
+        /// Get data of a readback request without copying it.
+        /// Under OpenGL, the array points directly into plugin's staging memory, and stays valid until ReleaseData() is called.
+        /// Otherwise it's Unity's own result, which is only valid for this frame.
+        /// Don't dispose the returned array, call ReleaseData() instead.
+        /// </summary>
+        /// <typeparam name="T"></typeparam>
+        /// <returns></returns>
+        public NativeArray<T> LeaseData<T>() where T : struct {
+            if (isPlugin) {
+                return oRequest.GetRawDataLease<T>();
+            } else {
+                return uRequest.GetData<T>();
+            }
+        }
+
+        /// <summary>
+        /// Under OpenGL, get the part of result already read back, without copying it. Large requests are transferred in chunks,
+        /// which become available from the beginning one after another before the request is done.
+        /// Otherwise it's empty until done. The array is valid for this frame only.
+        /// </summary>
+        public NativeArray<T> GetAvailableData<T>() where T : struct {
+            if (isPlugin) {
+                return oRequest.GetAvailableRawData<T>();
+            } else {
+                return uRequest.done && !uRequest.hasError ? uRequest.GetData<T>() : default(NativeArray<T>);
+            }
+        }
+
+        /// <summary>
+        /// End the lease taken by LeaseData(). The leased array must not be used anymore.
+        /// </summary>
+        public void ReleaseData() {
+            if (isPlugin) {
+                oRequest.ReleaseData();
+            }
+        }
+
         public bool valid {
             get {
                 return isPlugin ? oRequest.Valid() : (!uDisposd && uInited);
@@ -172,6 +717,16 @@ namespace Yangrc.OpenGLAsyncReadback {
 
         public bool isPlugin { get; private set; }
 
+        /// <summary>
+        /// Under OpenGL, handle of the request in plugin, for native plugins using SetCompletionCallback, see AsyncGPUReadbackCallbacks.h.
+        /// 0 when the request doesn't go through the plugin.
+        /// </summary>
+        public int nativeHandle {
+            get {
+                return isPlugin ? oRequest.nativeHandle : 0;
+            }
+        }
+
         //fields for unity request.
         private bool uInited;
         private bool uDisposd;
@@ -182,7 +737,30 @@ namespace Yangrc.OpenGLAsyncReadback {
 
     }
 
+    /// <summary>
+    /// State of a native request. Must match TaskState in native code.
+    /// </summary>
+    internal enum OpenGLReadbackTaskState : byte {
+        Invalid = 0,
+        Pending = 1,
+        Running = 2,
+        Done = 3,
+        Error = 4,
+        Dropped = 5,    //Superseded by a newer request of a latest-frame-only texture.
+        OverBudget = 6, //Rejected as in-flight byte budget is used up.
+    }
+
 	internal struct OpenGLAsyncReadbackRequest {
+        /// <summary>
+        /// Native table of request states, read directly so polling a request doesn't call into plugin.
+        /// </summary>
+        private static unsafe long* stateTable;
+        private static int stateTableMask;
+        /// <summary>
+        /// Plugin binary is older than the state table, states are then asked with TaskExists/TaskDone/TaskError.
+        /// </summary>
+        private static bool legacyStateQueries;
+
         public static bool IsAvailable() {
             return SystemInfo.graphicsDeviceType == GraphicsDeviceType.OpenGLCore;  //Not tested on es3 yet.
         }
@@ -191,14 +769,30 @@ namespace Yangrc.OpenGLAsyncReadback {
         /// </summary>
         private int nativeTaskHandle;
 
+        /// <summary>
+        /// Handle of the request in plugin. Native plugins could use it with SetCompletionCallback, see AsyncGPUReadbackCallbacks.h.
+        /// </summary>
+        public int nativeHandle {
+            get { return nativeTaskHandle; }
+        }
+
+        /// <summary>
+        /// Whether result goes into caller-provided memory. Plugin only copies it there once asked, which done does.
+        /// </summary>
+        private bool intoDestination;
+
 		/// <summary>
 		/// Check if the request is done
 		/// </summary>
 		public bool done
 	    {
 	        get {
-               // AssertRequestValid();
-                return TaskDone(nativeTaskHandle);
+                var state = ReadState(nativeTaskHandle);
+                if (intoDestination && state == OpenGLReadbackTaskState.Done) {
+                    CommitDestination();
+                }
+                //If it's disposed, also assume it's done.
+                return state >= OpenGLReadbackTaskState.Done || state == OpenGLReadbackTaskState.Invalid;
             }
 	    }
 
@@ -208,11 +802,24 @@ namespace Yangrc.OpenGLAsyncReadback {
 		public bool hasError
 	    {
 	        get {
-              //  AssertRequestValid();
-                return TaskError(nativeTaskHandle);
+                var state = ReadState(nativeTaskHandle);
+                //It's disposed, assume as error. Every state after Error has no data either.
+                return state >= OpenGLReadbackTaskState.Error || state == OpenGLReadbackTaskState.Invalid;
             }
 	    }
 
+        /// <summary>
+        /// Check if the request is rejected as in-flight byte budget is used up. It's also done with error then.
+        /// </summary>
+        public bool overBudget {
+            get {
+                return nativeTaskHandle == RequestOverBudget || ReadState(nativeTaskHandle) == OpenGLReadbackTaskState.OverBudget;
+            }
+        }
+
+        //Returned by native request functions instead of a handle, must match kRequestOverBudget.
+        private const int RequestOverBudget = -1;
+
         public static OpenGLAsyncReadbackRequest CreateTextureRequest(int textureOpenGLName, int mipmapLevel) {
             var result = new OpenGLAsyncReadbackRequest();
             result.nativeTaskHandle = RequestTextureMainThread(textureOpenGLName, mipmapLevel);
@@ -220,15 +827,137 @@ namespace Yangrc.OpenGLAsyncReadback {
             return result;
         }
 
-        public static OpenGLAsyncReadbackRequest CreateComputeBufferRequest(int computeBufferOpenGLName, int size) {
+        public static OpenGLAsyncReadbackRequest CreateTextureRegionRequest(int textureOpenGLName, int mipmapLevel, int x, int y, int z, int width, int height, int depth) {
+            var result = new OpenGLAsyncReadbackRequest();
+            result.nativeTaskHandle = RequestTextureRegionMainThread(textureOpenGLName, mipmapLevel, x, y, z, width, height, depth);
+            GL.IssuePluginEvent(GetKickstartFunctionPtr(), result.nativeTaskHandle);
+            return result;
+        }
+
+        /// <summary>
+        /// Same as the other overload, with info of the level already known, so render thread doesn't query it from driver.
+        /// </summary>
+        public static OpenGLAsyncReadbackRequest CreateTextureRegionRequest(int textureOpenGLName, int mipmapLevel, int x, int y, int z, int width, int height, int depth, OpenGLTextureLevelInfo info) {
+            var result = new OpenGLAsyncReadbackRequest();
+            result.nativeTaskHandle = RequestTextureRegionWithInfoMainThread(textureOpenGLName, mipmapLevel, x, y, z, width, height, depth, ref info);
+            GL.IssuePluginEvent(GetKickstartFunctionPtr(), result.nativeTaskHandle);
+            return result;
+        }
+
+        public static OpenGLAsyncReadbackRequest CreateComputeBufferRequest(int computeBufferOpenGLName, long size) {
             var result = new OpenGLAsyncReadbackRequest();
             result.nativeTaskHandle = RequestComputeBufferMainThread(computeBufferOpenGLName, size);
             GL.IssuePluginEvent(GetKickstartFunctionPtr(), result.nativeTaskHandle);
             return result;
         }
 
+        public static OpenGLAsyncReadbackRequest CreateComputeBufferRangeRequest(int computeBufferOpenGLName, long offset, long size) {
+            var result = new OpenGLAsyncReadbackRequest();
+            result.nativeTaskHandle = RequestComputeBufferRangeMainThread(computeBufferOpenGLName, offset, size);
+            GL.IssuePluginEvent(GetKickstartFunctionPtr(), result.nativeTaskHandle);
+            return result;
+        }
+
+        public static unsafe OpenGLAsyncReadbackRequest CreateTextureRequestInto(int textureOpenGLName, int mipmapLevel, void* destination, long capacity) {
+            var result = new OpenGLAsyncReadbackRequest();
+            result.nativeTaskHandle = RequestTextureIntoMainThread(textureOpenGLName, mipmapLevel, destination, (ulong)capacity);
+            result.intoDestination = true;
+            GL.IssuePluginEvent(GetKickstartFunctionPtr(), result.nativeTaskHandle);
+            return result;
+        }
+
+        public static unsafe OpenGLAsyncReadbackRequest CreateComputeBufferRequestInto(int computeBufferOpenGLName, long size, void* destination, long capacity) {
+            var result = new OpenGLAsyncReadbackRequest();
+            result.nativeTaskHandle = RequestComputeBufferIntoMainThread(computeBufferOpenGLName, size, destination, (ulong)capacity);
+            result.intoDestination = true;
+            GL.IssuePluginEvent(GetKickstartFunctionPtr(), result.nativeTaskHandle);
+            return result;
+        }
+
+        /// <summary>
+        /// Wrap a request made elsewhere, e.g. by OpenGLReadbackEvent in render thread.
+        /// </summary>
+        internal static OpenGLAsyncReadbackRequest FromHandle(int handle, bool intoDestination) {
+            var result = new OpenGLAsyncReadbackRequest();
+            result.nativeTaskHandle = handle;
+            result.intoDestination = intoDestination;
+            return result;
+        }
+
+        /// <summary>
+        /// Make all requests of descs with one call into plugin, and start them with one render event.
+        /// They share one fence, so they're done together.
+        /// </summary>
+        public static OpenGLAsyncReadbackRequest[] CreateBatchRequest(OpenGLReadbackRequestDesc[] descs) {
+            var handles = new int[descs.Length];
+            int batch = RequestBatchMainThread(descs, descs.Length, handles);
+            if (batch != 0) {
+                GL.IssuePluginEvent(GetKickstartBatchFunctionPtr(), batch);
+            }
+            var results = new OpenGLAsyncReadbackRequest[descs.Length];
+            for (int i = 0; i < descs.Length; i++) {
+                results[i].nativeTaskHandle = handles[i];
+            }
+            return results;
+        }
+
         public bool Valid() {
-            return TaskExists(this.nativeTaskHandle);
+            return ReadState(this.nativeTaskHandle) != OpenGLReadbackTaskState.Invalid;
+        }
+
+        /// <summary>
+        /// Read state of a request from the shared native table, without calling into plugin.
+        /// </summary>
+        private static unsafe OpenGLReadbackTaskState ReadState(int handle) {
+            if (handle <= 0) {
+                return OpenGLReadbackTaskState.Invalid;
+            }
+            if (stateTable == null && !legacyStateQueries) {
+                try {
+                    int capacity = 0;
+                    stateTable = (long*)GetTaskStateTable(ref capacity);
+                    stateTableMask = capacity - 1;
+                } catch (EntryPointNotFoundException) {
+                    legacyStateQueries = true;
+                }
+            }
+            if (legacyStateQueries) {
+                return ReadLegacyState(handle);
+            }
+            long word = Interlocked.Read(ref stateTable[handle & stateTableMask]);
+            if ((int)((ulong)word >> 32) != handle) {
+                return OpenGLReadbackTaskState.Invalid;
+            }
+            return (OpenGLReadbackTaskState)(word & 0xff);
+        }
+
+        private static OpenGLReadbackTaskState ReadLegacyState(int handle) {
+            if (!TaskExists(handle)) {
+                return OpenGLReadbackTaskState.Invalid;
+            }
+            if (TaskError(handle)) {
+                return OpenGLReadbackTaskState.Error;
+            }
+            return TaskDone(handle) ? OpenGLReadbackTaskState.Done : OpenGLReadbackTaskState.Running;
+        }
+
+        /// <summary>
+        /// Get states of many requests with one call into plugin.
+        /// </summary>
+        internal static unsafe void QueryStates(int[] handles, OpenGLReadbackTaskState[] states) {
+            if (states.Length < handles.Length) {
+                throw new ArgumentException("states is shorter than handles.");
+            }
+            if (legacyStateQueries) {
+                for (int i = 0; i < handles.Length; i++) {
+                    states[i] = ReadLegacyState(handles[i]);
+                }
+                return;
+            }
+            fixed (int* ids = handles)
+            fixed (OpenGLReadbackTaskState* outStates = states) {
+                QueryTaskStates(ids, handles.Length, (byte*)outStates);
+            }
         }
 
         private void AssertRequestValid() {
@@ -245,18 +974,98 @@ namespace Yangrc.OpenGLAsyncReadback {
             }
 			// Get data from cpp plugin
 			void* ptr = null;
-			int length = 0;
+			ulong length = 0;
 			GetData(this.nativeTaskHandle, ref ptr, ref length);
 
             //Copy data from plugin native memory to unity-controlled native memory.
-            var resultNativeArray = new NativeArray<T>(length / UnsafeUtility.SizeOf<T>(), Allocator.Temp);
-            UnsafeUtility.MemMove(resultNativeArray.GetUnsafePtr(), ptr, length);
-            //Though there exists an api named NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray.
-            //It's only for internal use. The document on docs.unity3d.com is a lie.
-            
+            var resultNativeArray = new NativeArray<T>(ElementCount<T>(length), Allocator.Temp);
+            UnsafeUtility.MemMove(resultNativeArray.GetUnsafePtr(), ptr, (long)length);
+            ReleaseData(this.nativeTaskHandle);
+
             return resultNativeArray;
 		}
 
+        /// <summary>
+        /// Get data as a view of plugin's staging memory, without any copy.
+        /// It stays valid until ReleaseData() is called.
+        /// </summary>
+        public unsafe NativeArray<T> GetRawDataLease<T>() where T : struct {
+            AssertRequestValid();
+            if (!done) {
+                throw new InvalidOperationException("The request is not done yet!");
+            }
+            void* ptr = null;
+            ulong length = 0;
+            GetData(this.nativeTaskHandle, ref ptr, ref length);
+
+            var resultNativeArray = NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray<T>(ptr, ElementCount<T>(length), Allocator.None);
+#if ENABLE_UNITY_COLLECTIONS_CHECKS
+            //Temp memory handle is invalidated at end of frame, a lease outlives it, so it gets its own until ReleaseData.
+            AtomicSafetyHandle safety;
+            if (!leaseSafetyHandles.TryGetValue(this.nativeTaskHandle, out safety)) {
+                safety = AtomicSafetyHandle.Create();
+                leaseSafetyHandles.Add(this.nativeTaskHandle, safety);
+            }
+            NativeArrayUnsafeUtility.SetAtomicSafetyHandle(ref resultNativeArray, safety);
+#endif
+            return resultNativeArray;
+        }
+
+#if ENABLE_UNITY_COLLECTIONS_CHECKS
+        //Safety handles of leased results, by request handle. Released with the lease.
+        private static Dictionary<int, AtomicSafetyHandle> leaseSafetyHandles = new Dictionary<int, AtomicSafetyHandle>();
+#endif
+
+        /// <summary>
+        /// Get the part of result already available as a view of plugin's memory, without any copy. Valid for this frame only.
+        /// </summary>
+        public unsafe NativeArray<T> GetAvailableRawData<T>() where T : struct {
+            void* ptr = null;
+            ulong length = 0;
+            GetAvailableData(this.nativeTaskHandle, ref ptr, ref length);
+
+            var resultNativeArray = NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray<T>(ptr, ElementCount<T>(length), Allocator.None);
+#if ENABLE_UNITY_COLLECTIONS_CHECKS
+            NativeArrayUnsafeUtility.SetAtomicSafetyHandle(ref resultNativeArray, AtomicSafetyHandle.GetTempMemoryHandle());
+#endif
+            return resultNativeArray;
+        }
+
+        /// <summary>
+        /// Make plugin copy the result into destination, if it hasn't yet.
+        /// </summary>
+        private unsafe void CommitDestination() {
+            void* ptr = null;
+            ulong length = 0;
+            GetAvailableData(this.nativeTaskHandle, ref ptr, ref length);
+        }
+
+        /// <summary>
+        /// Number of whole T in length bytes. NativeArray is indexed by int, so larger results must be read as larger T.
+        /// </summary>
+        internal static int ElementCount<T>(ulong length) where T : struct {
+            ulong count = length / (ulong)UnsafeUtility.SizeOf<T>();
+            if (count > int.MaxValue) {
+                throw new InvalidOperationException("The result has too many elements for a NativeArray, read it as a larger type.");
+            }
+            return (int)count;
+        }
+
+        public void ReleaseData() {
+#if ENABLE_UNITY_COLLECTIONS_CHECKS
+            AtomicSafetyHandle safety;
+            if (leaseSafetyHandles.TryGetValue(this.nativeTaskHandle, out safety)) {
+                AtomicSafetyHandle.Release(safety);
+                leaseSafetyHandles.Remove(this.nativeTaskHandle);
+            }
+#endif
+            try {
+                ReleaseData(this.nativeTaskHandle);
+            } catch (EntryPointNotFoundException) {
+                //Plugin binary is older than leases, its results are copies and there's nothing to release.
+            }
+        }
+
 		internal static void Update()
 		{
             UpdateMainThread();
@@ -268,20 +1077,118 @@ namespace Yangrc.OpenGLAsyncReadback {
         [DllImport("AsyncGPUReadbackPlugin")]
         private static extern int RequestTextureMainThread(int texture, int miplevel);
         [DllImport("AsyncGPUReadbackPlugin")]
-        private static extern int RequestComputeBufferMainThread(int bufferID, int bufferSize);
+        private static extern int RequestTextureRegionMainThread(int texture, int miplevel, int x, int y, int z, int width, int height, int depth);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern int RequestTextureRegionWithInfoMainThread(int texture, int miplevel, int x, int y, int z, int width, int height, int depth, ref OpenGLTextureLevelInfo info);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern int RequestComputeBufferMainThread(int bufferID, long bufferSize);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern int RequestComputeBufferRangeMainThread(int bufferID, long offset, long size);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern unsafe int RequestTextureIntoMainThread(int texture, int miplevel, void* destination, ulong capacity);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern unsafe int RequestComputeBufferIntoMainThread(int bufferID, long bufferSize, void* destination, ulong capacity);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern int RequestBatchMainThread([In] OpenGLReadbackRequestDesc[] descs, int count, [Out] int[] eventIds);
         [DllImport ("AsyncGPUReadbackPlugin")]
 		private static extern IntPtr GetKickstartFunctionPtr();
         [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern IntPtr GetKickstartBatchFunctionPtr();
+        [DllImport("AsyncGPUReadbackPlugin")]
         private static extern IntPtr UpdateMainThread();
         [DllImport("AsyncGPUReadbackPlugin")]
         private static extern IntPtr GetUpdateRenderThreadFunctionPtr();
         [DllImport ("AsyncGPUReadbackPlugin")]
-		private static extern unsafe void GetData(int event_id, ref void* buffer, ref int length);
+		private static extern unsafe void GetData(int event_id, ref void* buffer, ref ulong length);
         [DllImport("AsyncGPUReadbackPlugin")]
-        private static extern bool TaskError(int event_id);
+        private static extern unsafe void GetAvailableData(int event_id, ref void* buffer, ref ulong length);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void ReleaseData(int event_id);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern unsafe void QueryTaskStates(int* ids, int count, byte* outStates);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern unsafe void* GetTaskStateTable(ref int capacity);
         [DllImport("AsyncGPUReadbackPlugin")]
         private static extern bool TaskExists(int event_id);
-        [DllImport ("AsyncGPUReadbackPlugin")]
-		private static extern bool TaskDone(int event_id);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern bool TaskDone(int event_id);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern bool TaskError(int event_id);
 	}
+
+    /// <summary>
+    /// Continuous capture of a texture level. The plugin reads it back every frame into a ring of reused buffers,
+    /// so steady state capture doesn't allocate anything. Only available under OpenGL.
+    /// </summary>
+    public class OpenGLAsyncReadbackStream : IDisposable {
+        private int handle;
+
+        /// <summary>
+        /// Handle of the stream in plugin. Native plugins could use it with SetStreamCompletionCallback, see AsyncGPUReadbackCallbacks.h.
+        /// </summary>
+        public int nativeHandle {
+            get { return handle; }
+        }
+
+        /// <summary>
+        /// Start capturing src every frame.
+        /// </summary>
+        /// <param name="ringDepth">Number of frames in flight. Latency is at most this many frames, use at least 3.</param>
+        public static OpenGLAsyncReadbackStream Begin(Texture src, int mipmapIndex = 0, int ringDepth = 3) {
+            if (!OpenGLAsyncReadbackRequest.IsAvailable()) {
+                throw new NotSupportedException("Readback streams are only available under OpenGL.");
+            }
+            return new OpenGLAsyncReadbackStream() {
+                handle = BeginStream(RenderTextureRegistery.GetFor(src).ToInt32(), mipmapIndex, ringDepth),
+            };
+        }
+
+        /// <summary>
+        /// Get the newest captured frame, without any copy.
+        /// The data stays valid until next TryAcquireLatestFrame, ReleaseLatestFrame or Dispose.
+        /// </summary>
+        /// <param name="frameNumber">Number of the frame counted since Begin. The same frame is returned again if no newer one is captured.</param>
+        /// <returns>false if no frame is captured yet.</returns>
+        public unsafe bool TryAcquireLatestFrame<T>(out NativeArray<T> data, out long frameNumber) where T : struct {
+            void* ptr = null;
+            ulong length = 0;
+            frameNumber = -1;
+            if (!AcquireLatestFrame(handle, ref ptr, ref length, ref frameNumber)) {
+                data = default(NativeArray<T>);
+                return false;
+            }
+            data = NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray<T>(ptr, OpenGLAsyncReadbackRequest.ElementCount<T>(length), Allocator.None);
+#if ENABLE_UNITY_COLLECTIONS_CHECKS
+            NativeArrayUnsafeUtility.SetAtomicSafetyHandle(ref data, AtomicSafetyHandle.GetTempMemoryHandle());
+#endif
+            return true;
+        }
+
+        /// <summary>
+        /// Give back the frame early, so the plugin could capture into it again.
+        /// </summary>
+        public void ReleaseLatestFrame() {
+            ReleaseLatestFrame(handle);
+        }
+
+        /// <summary>
+        /// Stop capturing.
+        /// </summary>
+        public void Dispose() {
+            if (handle != 0) {
+                EndStream(handle);
+                handle = 0;
+            }
+        }
+
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern int BeginStream(int texture, int miplevel, int ringDepth);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        private static extern unsafe bool AcquireLatestFrame(int stream, ref void* buffer, ref ulong length, ref long frameNumber);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void ReleaseLatestFrame(int stream);
+        [DllImport("AsyncGPUReadbackPlugin")]
+        private static extern void EndStream(int stream);
+    }
 }
\ No newline at end of file